@@ -115,8 +115,25 @@ def play_immortal_game():
     pos.make_move_from_san("Be7#")
     assert pos.is_checkmate()
 
+IMMORTAL_GAME = [
+    "e4", "e5", "f4", "exf4", "Bc4", "Qh4+", "Kf1", "b5", "Bxb5", "Nf6",
+    "Nf3", "Qh6", "d3", "Nh5", "Nh4", "Qg5", "Nf5", "c6", "g4", "Nf6",
+    "Rg1", "cxb5", "h4", "Qg6", "h5", "Qg5", "Qf3", "Ng8", "Bxf4", "Qf6",
+    "Nc3", "Bc5", "Nd5", "Qxb2", "Bd6", "Bxg1", "e5", "Qxa1+", "Ke2", "Na6",
+    "Nxg7+", "Kd8", "Qf6+", "Nxf6", "Be7#"]
+
+def replay_immortal_game():
+    pos, hashes, illegal = chess.Position().replay_san(IMMORTAL_GAME)
+    assert illegal is None
+    assert pos.is_checkmate()
+
 if __name__ == "__main__":
     print timeit.timeit(
         stmt="play_immortal_game()",
         setup="from __main__ import play_immortal_game",
         number=100)
+
+    print timeit.timeit(
+        stmt="replay_immortal_game()",
+        setup="from __main__ import replay_immortal_game",
+        number=100)
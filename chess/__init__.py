@@ -34,6 +34,16 @@ from libchess import Piece
 from libchess import Move
 from libchess import Position
 from libchess import PolyglotOpeningBookEntry
+from libchess import PolyglotBook
+from libchess import PolyglotBookBuilder
+from libchess import PolyglotBookMerger
+from libchess import PgnVisitor
+from libchess import PgnParser
+from libchess import ParallelPgnParser
+from libchess import PgnIndexEntry
+from libchess import PgnIndex
+from libchess import GameDatabaseWriter
+from libchess import GameDatabaseReader
 
 # Stable.
 from chess.game_header_bag import GameHeaderBag
@@ -43,5 +53,6 @@ from chess.polyglot_opening_book import PolyglotOpeningBook
 from chess.game_node import GameNode
 from chess.game import Game
 from chess.pgn_file import PgnFile
+from chess.pgn_file import PgnError
 
 __all__ = [ name for name, obj in locals().items() if not inspect.ismodule(obj) ]
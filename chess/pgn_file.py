@@ -17,35 +17,102 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 import chess
-import re
-
-tag_regex = re.compile(r"\[([A-Za-z0-9]+)\s+\"(.*)\"\]")
-movetext_regex = re.compile(r"""
-    (\;.*?[\n\r])
-    |(\{.*?[^\\]\})
-    |(\$[0-9]+)
-    |(\()
-    |(\))
-    |(\*|1-0|0-1|1/2-1/2)
-    |(
-        ([a-hKQRBN][a-hxKQRBN1-8+#=\-]{1,6}
-        |O-O(?:\-O)?)
-        ([\?!]{1,2})*
-    )
-    """, re.DOTALL | re.VERBOSE)
+
+class PgnError(Exception):
+    """Raised for PGN that can not be turned into a game tree."""
+    pass
+
+class GameBuilder(chess.PgnVisitor):
+    """Builds game trees from the tokens of the native PGN parser and
+    passes each completed game to a callback."""
+
+    def __init__(self, callback):
+        chess.PgnVisitor.__init__(self)
+        self.callback = callback
+
+    def begin_game(self):
+        self.game = chess.Game()
+        self.variation_stack = [self.game]
+        self.in_variation = False
+        self.start_comment = ""
+
+    def header(self, name, value):
+        self.game.headers[name] = value
+
+    def san(self, san):
+        position = self.variation_stack[-1].position
+        self.move(san, position.get_move_from_san(str(san)))
+
+    def move(self, san, move):
+        # The parallel parser passes moves it already resolved.
+        node = self.variation_stack[-1].add_variation(move)
+        node.start_comment = self.start_comment
+        self.variation_stack[-1] = node
+        self.start_comment = ""
+        self.in_variation = True
+
+    def nag(self, nag):
+        if not self.in_variation:
+            raise PgnError("NAGs must go behind moves.")
+        self.variation_stack[-1].nags.append(nag)
+
+    def comment(self, comment):
+        if self.in_variation:
+            self.variation_stack[-1].comment += comment.strip()
+        elif len(self.variation_stack) == 1:
+            self.variation_stack[0].start_comment += comment.strip()
+        else:
+            self.start_comment += comment.strip()
+
+    def begin_variation(self):
+        self.variation_stack.append(self.variation_stack[-1].previous_node)
+        self.in_variation = False
+
+    def end_variation(self):
+        self.variation_stack.pop()
+        self.in_variation = self.variation_stack[-1].move is not None
+
+    def result(self, result):
+        self.game.headers["Result"] = result
+
+    def end_game(self):
+        self.callback(self.game)
+
 
 class PgnFile(object):
     def __init__(self):
+        # Games or, for files opened with an index, the numbers of games
+        # that have not been parsed.
         self._games = []
+        self._index = None
+
+    @property
+    def index(self):
+        """The `chess.PgnIndex` of a file opened with an index, or
+        `None`."""
+        return self._index
 
     def add_game(self, game):
         self._games.append(game)
 
+    def _load(self, index):
+        # Games of files opened with an index are parsed on first access
+        # and kept, so that changes to them are not lost.
+        game = self._games[index]
+        if not isinstance(game, chess.Game):
+            games = []
+            self._index.parse_game(game, GameBuilder(games.append))
+            game = self._games[index] = games[0]
+        return game
+
     def __len__(self):
         return len(self._games)
 
     def __getitem__(self, key):
-        return self._games[key]
+        if isinstance(key, slice):
+            return [self._load(i) for i in range(*key.indices(len(self._games)))]
+        else:
+            return self._load(key)
 
     def __setitem__(self, key, value):
         self._games[key] = value
@@ -54,94 +121,57 @@ class PgnFile(object):
         del self._games[key]
 
     def __iter__(self):
-        for game in self._games:
-            yield game
+        for i in range(len(self._games)):
+            yield self._load(i)
 
     def __reversed__(self):
-        for game in reversed(self._games):
-            yield game
+        for i in reversed(range(len(self._games))):
+            yield self._load(i)
 
     def __contains__(self, game):
         return game in self._games
 
     @staticmethod
-    def __parse_movetext(game, movetext):
-        variation_stack = [game]
-        in_variation = False
-        start_comment = ""
-        for match in movetext_regex.finditer(movetext):
-            token = match.group(0)
-            if token in ["1-0", "0-1", "1/2-1/2", "*"] and len(variation_stack) == 1:
-                game.headers["Result"] = token
-            elif token.startswith("%"):
-                # Ignore rest of line comments.
-                pass
-            elif token.startswith("{"):
-                if in_variation:
-                    variation_stack[-1].comment += token[1:-1].strip()
-                elif len(variation_stack) == 1:
-                    variation_stack[0].start_comment += token[1:-1].strip()
-                else:
-                    start_comment += token[1:-1].strip()
-            elif token.startswith("$"):
-                if not in_variation:
-                    raise PgnError("NAGs must go behind moves.")
-                variation_stack[-1].nags.append(int(token[1:]))
-            elif token == "(":
-                variation_stack.append(variation_stack[-1].previous_node)
-                in_variation = False
-            elif token == ")":
-                variation_stack.pop()
-            else:
-                in_variation = True
-                pos = variation_stack[-1].position
-                variation_stack[-1] = variation_stack[-1].add_variation(pos.get_move_from_san(str(token)))
-                variation_stack[-1].start_comment = start_comment
-                start_comment = ""
-
+    def scan_headers(path):
+        """Yields the headers of each game in a PGN file as a dictionary.
+
+        The movetext is skipped without parsing any moves, so this is much
+        faster than opening the file when only the headers are needed.
+        """
+        with open(path, "rb") as f:
+            parser = chess.PgnParser(f.fileno())
+            while True:
+                headers = parser.read_headers()
+                if headers is None:
+                    break
+                yield headers
 
     @classmethod
-    def open(cls, path):
+    def open(cls, path, threads=1, index=False):
+        """Reads all games of a PGN file.
+
+        :param threads:
+            With more than one thread the file is split into chunks of
+            games that are parsed and validated in parallel, without
+            holding the GIL. `0` uses all cores. Defaults to `1`.
+        :param index:
+            If `True` the games are not read up front. Instead a sidecar
+            index with the offsets of the games is created or updated and
+            each game is parsed when it is accessed. Defaults to `False`.
+        """
         pgn_file = PgnFile()
-        current_game = None
-        in_tags = False
-
-        for line in open(path, 'r'):
-            # Decode and strip the line.
-            line = line.decode('latin-1').strip()
-
-            # Skip empty lines and comments.
-            if not line or line.startswith("%"):
-                continue
-
-            # Check for tag lines.
-            tag_match = tag_regex.match(line)
-            if tag_match:
-                tag_name = tag_match.group(1)
-                tag_value = tag_match.group(2).replace("\\\\", "\\").replace("\\[", "]").replace("\\\"", "\"")
-                if current_game:
-                    if in_tags:
-                        current_game.headers[tag_name] = tag_value
-                    else:
-                        cls.__parse_movetext(current_game, movetext)
-                        pgn_file.add_game(current_game)
-                        current_game = None
-                if not current_game:
-                    current_game = chess.Game()
-                    current_game.headers[tag_name] = tag_value
-                    movetext = ""
-                in_tags = True
-            # Parse movetext lines.
+
+        if index:
+            pgn_file._index = chess.PgnIndex(path)
+            pgn_file._games = list(range(len(pgn_file._index)))
+            return pgn_file
+
+        builder = GameBuilder(pgn_file.add_game)
+
+        with open(path, "rb") as f:
+            if threads == 1:
+                chess.PgnParser(f.fileno()).parse(builder)
             else:
-                if current_game:
-                    movetext += "\n" + line
-                    pass
-                else:
-                    raise chess.PgnError("Invalid PGN. Expected header before movetext: %s", repr(line))
-                in_tags = False
-
-        if current_game:
-            cls.__parse_movetext(current_game, movetext)
-            pgn_file.add_game(current_game)
+                chess.ParallelPgnParser(f.fileno(), threads).parse(builder)
 
         return pgn_file
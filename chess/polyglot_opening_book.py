@@ -17,20 +17,19 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 import chess
-import struct
 
 # TODO: Also allow writing to opening books and document the class.
 
 class PolyglotOpeningBook(object):
-    def __init__(self, path):
-        self._entry_struct = struct.Struct(">QHHI")
+    def __init__(self, path, load_into_memory=False):
+        # All access goes through the memory mapped book.
+        self._book = chess.PolyglotBook(path)
+        self._entry_count = len(self._book)
+        self._offset = 0
 
-        self._stream = open(path, "rb")
-
-        self.seek_entry(0, 2)
-        self._entry_count = self._stream.tell() / 16
-
-        self.seek_entry(0)
+        # Index the keys of hot books for faster lookups.
+        if load_into_memory:
+            self._book.load_into_memory()
 
     def __len__(self):
         return self._entry_count
@@ -47,67 +46,35 @@ class PolyglotOpeningBook(object):
 
     def __reversed__(self):
         for i in xrange(len(self) - 1, -1, -1):
-            self.seek_entry(i)
-            yield self.next()
+            yield self._book[i]
 
     def seek_entry(self, offset, whence=0):
-        self._stream.seek(offset * 16, whence)
+        if whence == 1:
+            offset += self._offset
+        elif whence == 2:
+            offset += self._entry_count
+        self._offset = offset
 
     def seek_position(self, position):
-        # Calculate the position hash.
-        key = position.__hash__()
-
-        # Do a binary search.
-        start = 0
-        end = len(self)
-        while end >= start:
-            middle = (start + end) / 2
-
-            self.seek_entry(middle)
-            raw_entry = self.next_raw()
-
-            if raw_entry[0] < key:
-                start = middle + 1
-            elif raw_entry[0] > key:
-                end = middle - 1
-            else:
-                # Position found. Move back to the first occurence.
-                self.seek_entry(-1, 1)
-                while raw_entry[0] == key and middle > start:
-                    middle -= 1
-                    self.seek_entry(middle)
-                    raw_entry = self.next_raw()
-
-                    if middle == start and raw_entry[0] == key:
-                        self.seek_entry(-1, 1)
-                return
-
-        raise KeyError()
+        # Find the first entry for the position.
+        offset = self._book.lower_bound(position.__hash__())
+        if offset >= self._entry_count or self._book[offset].key != position.__hash__():
+            raise KeyError()
+        self.seek_entry(offset)
 
     def next_raw(self):
-        try:
-            return self._entry_struct.unpack(self._stream.read(16))
-        except struct.error:
-            raise StopIteration()
+        entry = self.next()
+        return (entry.key, entry.raw_move, entry.weight, entry.learn)
 
     def next(self):
-        raw_entry = self.next_raw()
-        return chess.PolyglotOpeningBookEntry(raw_entry[0], raw_entry[1],
-                                              raw_entry[2], raw_entry[3]);
-
-    def get_entries_for_position(self, position):
-        position_hash = position.__hash__()
-
-        # Seek the position. Stop iteration if no entry exists.
-        try:
-            self.seek_position(position)
-        except KeyError:
+        if not 0 <= self._offset < self._entry_count:
             raise StopIteration()
+        entry = self._book[self._offset]
+        self._offset += 1
+        return entry
+
+    __next__ = next
 
-        # Iterate.
-        while True:
-            entry = self.next()
-            if entry.key == position_hash:
-                yield entry
-            else:
-                break
+    def get_entries_for_position(self, position):
+        # Look up the entries in the memory mapped book.
+        return iter(self._book.find(position))
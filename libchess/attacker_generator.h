@@ -17,6 +17,7 @@
 #ifndef LIBCHESS_ATTACKER_GENERATOR_H
 #define LIBCHESS_ATTACKER_GENERATOR_H
 
+#include "bitboard.h"
 #include "position.h"
 
 namespace chess {
@@ -26,11 +27,13 @@ class Position;
 /**
  * \brief Enumerates attackers of a given side on a specific square of the
  *   given position.
+ *
+ * The attackers are computed once as a bitboard with
+ * Position::attackers_to().
  */
 class AttackerGenerator : boost::noncopyable {
 public:
     AttackerGenerator(const Position& position, char color, const Square& target);
-    ~AttackerGenerator();
 
     int __len__();
     bool __nonzero__();
@@ -42,10 +45,8 @@ public:
     Square python_next();
 
 private:
-    char m_color;
-    Position* m_position;
-    Square m_target;
-    int m_source_index;
+    Bitboard m_attackers;
+    Bitboard m_remaining;
 };
 
 } // namespace chess
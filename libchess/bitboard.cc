@@ -0,0 +1,202 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include "bitboard.h"
+
+namespace chess {
+
+Bitboard BB_KNIGHT_ATTACKS[64];
+Bitboard BB_KING_ATTACKS[64];
+Bitboard BB_PAWN_ATTACKS[2][64];
+Bitboard BB_BETWEEN[64][64];
+Bitboard BB_LINE[64][64];
+
+Magic BISHOP_MAGICS[64];
+Magic ROOK_MAGICS[64];
+
+namespace {
+
+const int BISHOP_DELTAS[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+const int ROOK_DELTAS[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+Bitboard step_attacks(int square, const int deltas[][2], int count) {
+    Bitboard attacks = BB_VOID;
+    int rank = square / 8;
+    int file = square % 8;
+
+    for (int i = 0; i < count; i++) {
+        int r = rank + deltas[i][0];
+        int f = file + deltas[i][1];
+        if (r >= 0 && r < 8 && f >= 0 && f < 8) {
+            attacks |= bb_square(r * 8 + f);
+        }
+    }
+
+    return attacks;
+}
+
+Bitboard sliding_attacks(int square, Bitboard occupied, const int deltas[4][2]) {
+    Bitboard attacks = BB_VOID;
+
+    for (int i = 0; i < 4; i++) {
+        int r = square / 8 + deltas[i][0];
+        int f = square % 8 + deltas[i][1];
+        while (r >= 0 && r < 8 && f >= 0 && f < 8) {
+            Bitboard bb = bb_square(r * 8 + f);
+            attacks |= bb;
+            if (occupied & bb) {
+                break;
+            }
+            r += deltas[i][0];
+            f += deltas[i][1];
+        }
+    }
+
+    return attacks;
+}
+
+// Backing storage for the slider attacks of all squares.
+Bitboard BISHOP_TABLE[0x1480];
+Bitboard ROOK_TABLE[0x19000];
+
+// A xorshift64* generator for the magic number search. Sparse candidates
+// are much more likely to be magic, so a few outputs are and-ed together.
+class MagicRandom {
+public:
+    MagicRandom(uint64_t seed) : m_state(seed) { }
+
+    Bitboard sparse() {
+        return next() & next() & next();
+    }
+
+private:
+    uint64_t next() {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * U64(2685821657736338717);
+    }
+
+    uint64_t m_state;
+};
+
+// Finds a magic number for every square and fills the attack table.
+// Seeds per rank are chosen so that the search terminates quickly. The
+// magics are found deterministically, so the tables are the same on every
+// load.
+void init_magics(Magic magics[64], Bitboard *table, const int deltas[4][2]) {
+    Bitboard occupancy[4096];
+    Bitboard reference[4096];
+    int epoch[4096] = { 0 };
+    int current = 0;
+
+    for (int square = 0; square < 64; square++) {
+        Magic& m = magics[square];
+
+        // The edges only matter if the piece is on them.
+        Bitboard edges = ((BB_RANK_1 | BB_RANK_8) & ~(BB_RANK_1 << (8 * (square / 8)))) |
+                         ((BB_FILE_A | BB_FILE_H) & ~(BB_FILE_A << (square % 8)));
+        m.mask = sliding_attacks(square, BB_VOID, deltas) & ~edges;
+        m.shift = 64 - bb_popcount(m.mask);
+        m.attacks = (square == 0) ? table : magics[square - 1].attacks + (1 << (64 - magics[square - 1].shift));
+
+        // Enumerate all subsets of the mask with the Carry-Rippler trick
+        // and store the reference attacks.
+        int size = 0;
+        Bitboard b = BB_VOID;
+        do {
+            occupancy[size] = b;
+            reference[size] = sliding_attacks(square, b, deltas);
+#ifdef __BMI2__
+            m.attacks[_pext_u64(b, m.mask)] = reference[size];
+#endif
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+#ifndef __BMI2__
+        // Try candidates until one maps all subsets without destructive
+        // collisions.
+        const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+        MagicRandom random(seeds[square / 8]);
+        for (int i = 0; i < size; ) {
+            for (m.magic = 0; bb_popcount((m.magic * m.mask) >> 56) < 6; ) {
+                m.magic = random.sparse();
+            }
+
+            current++;
+            for (i = 0; i < size; i++) {
+                unsigned int index = m.index(occupancy[i]);
+                if (epoch[index] < current) {
+                    epoch[index] = current;
+                    m.attacks[index] = reference[i];
+                } else if (m.attacks[index] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+// Fills the attack tables when the library is loaded.
+struct BitboardTables {
+    BitboardTables() {
+        const int knight_deltas[8][2] = {
+            { 2, 1 }, { 2, -1 }, { -2, 1 }, { -2, -1 },
+            { 1, 2 }, { 1, -2 }, { -1, 2 }, { -1, -2 } };
+        const int king_deltas[8][2] = {
+            { 1, -1 }, { 1, 0 }, { 1, 1 }, { 0, -1 },
+            { 0, 1 }, { -1, -1 }, { -1, 0 }, { -1, 1 } };
+        const int white_pawn_deltas[2][2] = { { 1, -1 }, { 1, 1 } };
+        const int black_pawn_deltas[2][2] = { { -1, -1 }, { -1, 1 } };
+
+        for (int square = 0; square < 64; square++) {
+            BB_KNIGHT_ATTACKS[square] = step_attacks(square, knight_deltas, 8);
+            BB_KING_ATTACKS[square] = step_attacks(square, king_deltas, 8);
+            BB_PAWN_ATTACKS[0][square] = step_attacks(square, white_pawn_deltas, 2);
+            BB_PAWN_ATTACKS[1][square] = step_attacks(square, black_pawn_deltas, 2);
+        }
+
+        init_magics(BISHOP_MAGICS, BISHOP_TABLE, BISHOP_DELTAS);
+        init_magics(ROOK_MAGICS, ROOK_TABLE, ROOK_DELTAS);
+
+        for (int a = 0; a < 64; a++) {
+            for (int b = 0; b < 64; b++) {
+                const int (*deltas)[2];
+                if (bb_rook_attacks(a, BB_VOID) & bb_square(b)) {
+                    deltas = ROOK_DELTAS;
+                } else if (bb_bishop_attacks(a, BB_VOID) & bb_square(b)) {
+                    deltas = BISHOP_DELTAS;
+                } else {
+                    BB_BETWEEN[a][b] = BB_VOID;
+                    BB_LINE[a][b] = BB_VOID;
+                    continue;
+                }
+
+                BB_BETWEEN[a][b] = sliding_attacks(a, bb_square(b), deltas) &
+                                   sliding_attacks(b, bb_square(a), deltas);
+                BB_LINE[a][b] = (sliding_attacks(a, BB_VOID, deltas) &
+                                 sliding_attacks(b, BB_VOID, deltas)) |
+                                bb_square(a) | bb_square(b);
+            }
+        }
+    }
+} bitboard_tables;
+
+} // anonymous namespace
+
+} // namespace chess
@@ -0,0 +1,142 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_BITBOARD_H
+#define LIBCHESS_BITBOARD_H
+
+// Provides the Bitboard type, bit twiddling helpers and precomputed attack
+// tables. Bit i of a bitboard corresponds to the square with index i, so
+// a1 is the least significant bit and h8 the most significant one.
+
+#include "uint.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace chess {
+
+typedef uint64_t Bitboard;
+
+const Bitboard BB_VOID = U64(0);
+const Bitboard BB_ALL = U64(0xffffffffffffffff);
+
+const Bitboard BB_FILE_A = U64(0x0101010101010101);
+const Bitboard BB_FILE_H = U64(0x8080808080808080);
+
+const Bitboard BB_RANK_1 = U64(0x00000000000000ff);
+const Bitboard BB_RANK_2 = U64(0x000000000000ff00);
+const Bitboard BB_RANK_3 = U64(0x0000000000ff0000);
+const Bitboard BB_RANK_4 = U64(0x00000000ff000000);
+const Bitboard BB_RANK_5 = U64(0x000000ff00000000);
+const Bitboard BB_RANK_6 = U64(0x0000ff0000000000);
+const Bitboard BB_RANK_7 = U64(0x00ff000000000000);
+const Bitboard BB_RANK_8 = U64(0xff00000000000000);
+const Bitboard BB_BACKRANKS = BB_RANK_1 | BB_RANK_8;
+
+const Bitboard BB_LIGHT_SQUARES = U64(0x55aa55aa55aa55aa);
+const Bitboard BB_DARK_SQUARES = U64(0xaa55aa55aa55aa55);
+
+inline Bitboard bb_square(int index) {
+    return U64(1) << index;
+}
+
+inline int bb_popcount(Bitboard b) {
+#ifdef _MSC_VER
+    return (int) __popcnt64(b);
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// The index of the least significant set bit. b must not be empty.
+inline int bb_lsb(Bitboard b) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return (int) index;
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+// Clears the least significant set bit and returns its index.
+inline int bb_pop_lsb(Bitboard& b) {
+    int index = bb_lsb(b);
+    b &= b - 1;
+    return index;
+}
+
+inline Bitboard bb_shift_up(Bitboard b) {
+    return b << 8;
+}
+
+inline Bitboard bb_shift_down(Bitboard b) {
+    return b >> 8;
+}
+
+// Attack tables for the non-sliding pieces. BB_PAWN_ATTACKS is indexed by
+// color index first (0 for white, 1 for black).
+extern Bitboard BB_KNIGHT_ATTACKS[64];
+extern Bitboard BB_KING_ATTACKS[64];
+extern Bitboard BB_PAWN_ATTACKS[2][64];
+
+// The squares strictly between two squares on a common rank, file or
+// diagonal, and the whole line through them. Both are empty if the squares
+// are not aligned.
+extern Bitboard BB_BETWEEN[64][64];
+extern Bitboard BB_LINE[64][64];
+
+// Slider attacks are looked up in tables indexed by the relevant
+// occupancy of the square. The index is computed with a multiplication by
+// a magic number, or with the PEXT instruction when compiling for BMI2.
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard *attacks;
+    unsigned int shift;
+
+    unsigned int index(Bitboard occupied) const {
+#ifdef __BMI2__
+        return (unsigned int) _pext_u64(occupied, mask);
+#else
+        return (unsigned int) (((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Magic BISHOP_MAGICS[64];
+extern Magic ROOK_MAGICS[64];
+
+inline Bitboard bb_bishop_attacks(int square, Bitboard occupied) {
+    return BISHOP_MAGICS[square].attacks[BISHOP_MAGICS[square].index(occupied)];
+}
+
+inline Bitboard bb_rook_attacks(int square, Bitboard occupied) {
+    return ROOK_MAGICS[square].attacks[ROOK_MAGICS[square].index(occupied)];
+}
+
+inline Bitboard bb_queen_attacks(int square, Bitboard occupied) {
+    return bb_bishop_attacks(square, occupied) | bb_rook_attacks(square, occupied);
+}
+
+} // namespace chess
+
+#endif // LIBCHESS_BITBOARD_H
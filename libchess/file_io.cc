@@ -0,0 +1,68 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include <cerrno>
+#include <unistd.h>
+
+#include "file_io.h"
+
+namespace chess {
+
+bool write_fully(int fd, const char *data, size_t length) {
+    while (length) {
+        ssize_t count = write(fd, data, length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            return false;
+        }
+        data += count;
+        length -= count;
+    }
+    return true;
+}
+
+bool read_fully_at(int fd, char *data, size_t length, uint64_t offset) {
+    while (length) {
+        ssize_t count = pread(fd, data, length, offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            return false;
+        }
+        data += count;
+        length -= count;
+        offset += count;
+    }
+    return true;
+}
+
+bool write_fully_at(int fd, const char *data, size_t length, uint64_t offset) {
+    while (length) {
+        ssize_t count = pwrite(fd, data, length, offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            return false;
+        }
+        data += count;
+        length -= count;
+        offset += count;
+    }
+    return true;
+}
+
+} // namespace chess
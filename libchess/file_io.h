@@ -0,0 +1,37 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_FILE_IO_H
+#define LIBCHESS_FILE_IO_H
+
+#include <cstddef>
+
+#include "uint.h"
+
+namespace chess {
+
+// Helpers for reading and writing whole blocks of data on file
+// descriptors. Interrupted calls are retried. They return false on
+// errors and, for reads, at the end of the file, leaving it to the caller
+// to report the error.
+
+bool write_fully(int fd, const char *data, size_t length);
+bool read_fully_at(int fd, char *data, size_t length, uint64_t offset);
+bool write_fully_at(int fd, const char *data, size_t length, uint64_t offset);
+
+} // namespace chess
+
+#endif // LIBCHESS_FILE_IO_H
@@ -0,0 +1,403 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "libchess.h"
+#include "game_database.h"
+#include "file_io.h"
+
+#include <boost/python/stl_iterator.hpp>
+
+namespace chess {
+
+namespace {
+
+const char DATABASE_MAGIC[8] = { 'L', 'C', 'G', 'A', 'M', 'E', 'S', '1' };
+
+// Limits for the lengths stored in a record. Readers check them before
+// allocating, so that a corrupt file can not request huge amounts of
+// memory, and writers never produce records that exceed them.
+const uint64_t MAX_HEADERS = 4096;
+const uint64_t MAX_STRING_LENGTH = 64 * 1024;
+const uint64_t MAX_PLIES = 65536;
+
+bool within_limits(const GameHeaders& headers, uint64_t plies) {
+    if (headers.size() > MAX_HEADERS || plies > MAX_PLIES) {
+        return false;
+    }
+    for (unsigned int i = 0; i < headers.size(); i++) {
+        if (headers[i].first.length() > MAX_STRING_LENGTH ||
+                headers[i].second.length() > MAX_STRING_LENGTH) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void set_start_position(Position& position, const GameHeaders& headers) {
+    for (unsigned int i = 0; i < headers.size(); i++) {
+        if (headers[i].first == "FEN") {
+            position.set_fen(headers[i].second.c_str(), headers[i].second.length());
+        }
+    }
+}
+
+} // anonymous namespace
+
+/**
+ * \brief Converts the main line of PGN games to move indexes.
+ *
+ * Games with moves that can not be played are not written.
+ */
+class GameDatabaseWriter::PgnConverter : public PgnVisitor {
+public:
+    PgnConverter(GameDatabaseWriter& writer) : m_writer(writer), m_games(0) { }
+
+    void begin_game() {
+        m_headers.clear();
+        m_plies.clear();
+        m_depth = 0;
+        m_valid = true;
+    }
+
+    void header(const std::string& name, const std::string& value) {
+        m_headers.push_back(std::make_pair(name, value));
+    }
+
+    void end_headers() {
+        m_position.reset();
+        try {
+            set_start_position(m_position, m_headers);
+        } catch (const std::invalid_argument& e) {
+            m_valid = false;
+        } catch (std::invalid_argument *e) {
+            delete e;
+            m_valid = false;
+        }
+    }
+
+    void san(const std::string& san) {
+        if (!m_valid || m_depth) {
+            return;
+        }
+
+        Move move;
+        try {
+            move = m_position.get_move_from_san(san.c_str(), san.length());
+        } catch (const std::invalid_argument& e) {
+            m_valid = false;
+            return;
+        } catch (std::invalid_argument *e) {
+            delete e;
+            m_valid = false;
+            return;
+        }
+
+        int index = encode_move(m_position, move);
+        if (index < 0) {
+            m_valid = false;
+            return;
+        }
+        m_plies.push_back(index);
+    }
+
+    void begin_variation() {
+        m_depth++;
+    }
+
+    void end_variation() {
+        m_depth--;
+    }
+
+    void end_game() {
+        if (m_valid && within_limits(m_headers, m_plies.size())) {
+            m_writer.write_record(m_headers, m_plies);
+            m_games++;
+        }
+    }
+
+    int games() const {
+        return m_games;
+    }
+
+private:
+    GameDatabaseWriter& m_writer;
+    GameHeaders m_headers;
+    std::vector<unsigned char> m_plies;
+    Position m_position;
+    int m_depth;
+    bool m_valid;
+    int m_games;
+};
+
+GameDatabaseWriter::GameDatabaseWriter(int fd) : m_fd(fd) {
+    // Start new files with the magic number. Otherwise games are appended.
+    if (lseek(fd, 0, SEEK_END) <= 0) {
+        m_buffer.insert(m_buffer.end(), DATABASE_MAGIC, DATABASE_MAGIC + sizeof(DATABASE_MAGIC));
+    }
+}
+
+GameDatabaseWriter::~GameDatabaseWriter() {
+    try {
+        flush();
+    } catch (std::invalid_argument *e) {
+        delete e;
+    }
+}
+
+int GameDatabaseWriter::encode_move(Position& position, const Move& move) {
+    MoveList legal_moves;
+    LegalMoveGenerator::generate(position, legal_moves);
+
+    int index = legal_moves.index_of(move);
+    if (index >= 0) {
+        position.make_unvalidated_move_fast(move);
+    }
+    return index;
+}
+
+void GameDatabaseWriter::put_varint(uint64_t value) {
+    while (value >= 0x80) {
+        m_buffer.push_back((char) (value | 0x80));
+        value >>= 7;
+    }
+    m_buffer.push_back((char) value);
+}
+
+void GameDatabaseWriter::put_string(const std::string& str) {
+    put_varint(str.length());
+    m_buffer.insert(m_buffer.end(), str.begin(), str.end());
+}
+
+void GameDatabaseWriter::write_record(const GameHeaders& headers, const std::vector<unsigned char>& plies) {
+    put_varint(headers.size());
+    for (unsigned int i = 0; i < headers.size(); i++) {
+        put_string(headers[i].first);
+        put_string(headers[i].second);
+    }
+
+    put_varint(plies.size());
+    m_buffer.insert(m_buffer.end(), plies.begin(), plies.end());
+
+    if (m_buffer.size() >= 64 * 1024) {
+        flush();
+    }
+}
+
+void GameDatabaseWriter::write_game(const GameHeaders& headers, const std::vector<Move>& moves) {
+    Position position;
+    set_start_position(position, headers);
+
+    // Encode all moves before anything is written.
+    std::vector<unsigned char> plies;
+    plies.reserve(moves.size());
+    for (unsigned int i = 0; i < moves.size(); i++) {
+        int index = encode_move(position, moves[i]);
+        if (index < 0) {
+            throw new std::invalid_argument("moves");
+        }
+        plies.push_back(index);
+    }
+
+    if (!within_limits(headers, plies.size())) {
+        throw new std::invalid_argument("game too long");
+    }
+
+    write_record(headers, plies);
+}
+
+int GameDatabaseWriter::write_pgn(PgnParser& parser) {
+    PgnConverter converter(*this);
+    parser.parse(converter);
+    return converter.games();
+}
+
+void GameDatabaseWriter::flush() {
+    if (!m_buffer.empty()) {
+        if (!write_fully(m_fd, &m_buffer[0], m_buffer.size())) {
+            throw new std::invalid_argument("fd");
+        }
+        m_buffer.clear();
+    }
+}
+
+void GameDatabaseWriter::python_write_game(const boost::python::object& headers, const boost::python::object& moves) {
+    GameHeaders game_headers;
+    boost::python::object items = PyObject_HasAttrString(headers.ptr(), "items") ? headers.attr("items")() : headers;
+    boost::python::stl_input_iterator<boost::python::object> item(items), end;
+    for (; item != end; ++item) {
+        game_headers.push_back(std::make_pair(
+            python_to_latin1((*item)[0]), python_to_latin1((*item)[1])));
+    }
+
+    std::vector<Move> game_moves;
+    boost::python::stl_input_iterator<Move> move(moves), moves_end;
+    for (; move != moves_end; ++move) {
+        game_moves.push_back(*move);
+    }
+
+    write_game(game_headers, game_moves);
+}
+
+GameDatabaseReader::GameDatabaseReader(int fd) : m_fd(fd), m_buffer(new char[BUFFER_SIZE]) {
+    m_position = m_end = m_buffer.get();
+
+    // An empty file has no magic number and no games.
+    char magic[sizeof(DATABASE_MAGIC)];
+    for (unsigned int i = 0; i < sizeof(magic); i++) {
+        unsigned char byte;
+        if (!get_byte(byte)) {
+            if (i == 0) {
+                return;
+            }
+            throw new std::invalid_argument("magic");
+        }
+        magic[i] = byte;
+    }
+
+    if (std::memcmp(magic, DATABASE_MAGIC, sizeof(magic)) != 0) {
+        throw new std::invalid_argument("magic");
+    }
+}
+
+bool GameDatabaseReader::fill() {
+    ssize_t length;
+    do {
+        length = read(m_fd, m_buffer.get(), BUFFER_SIZE);
+    } while (length < 0 && errno == EINTR);
+
+    if (length < 0) {
+        throw new std::invalid_argument("fd");
+    }
+
+    m_position = m_buffer.get();
+    m_end = m_position + length;
+    return length > 0;
+}
+
+bool GameDatabaseReader::get_byte(unsigned char& byte) {
+    if (m_position == m_end && !fill()) {
+        return false;
+    }
+    byte = *m_position++;
+    return true;
+}
+
+uint64_t GameDatabaseReader::get_varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        unsigned char byte;
+        if (!get_byte(byte)) {
+            throw new std::invalid_argument("truncated");
+        }
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw new std::invalid_argument("varint");
+}
+
+void GameDatabaseReader::get_string(std::string& str) {
+    uint64_t length = get_varint();
+    if (length > MAX_STRING_LENGTH) {
+        throw new std::invalid_argument("string length");
+    }
+    str.clear();
+
+    while (length) {
+        if (m_position == m_end && !fill()) {
+            throw new std::invalid_argument("truncated");
+        }
+        size_t count = std::min<uint64_t>(length, m_end - m_position);
+        str.append(m_position, count);
+        m_position += count;
+        length -= count;
+    }
+}
+
+bool GameDatabaseReader::read_game(GameHeaders& headers, std::vector<Move>& moves) {
+    headers.clear();
+    moves.clear();
+
+    if (m_position == m_end && !fill()) {
+        return false;
+    }
+
+    uint64_t header_count = get_varint();
+    if (header_count > MAX_HEADERS) {
+        throw new std::invalid_argument("header count");
+    }
+    headers.resize(header_count);
+    for (unsigned int i = 0; i < headers.size(); i++) {
+        get_string(headers[i].first);
+        get_string(headers[i].second);
+    }
+
+    Position position;
+    set_start_position(position, headers);
+
+    uint64_t plies = get_varint();
+    if (plies > MAX_PLIES) {
+        throw new std::invalid_argument("ply count");
+    }
+    moves.reserve(plies);
+    MoveList legal_moves;
+    for (uint64_t i = 0; i < plies; i++) {
+        unsigned char index;
+        if (!get_byte(index)) {
+            throw new std::invalid_argument("truncated");
+        }
+
+        legal_moves.clear();
+        LegalMoveGenerator::generate(position, legal_moves);
+        if (index >= legal_moves.size()) {
+            throw new std::invalid_argument("move index");
+        }
+
+        moves.push_back(legal_moves[index]);
+        position.make_unvalidated_move_fast(legal_moves[index]);
+    }
+
+    return true;
+}
+
+boost::python::object GameDatabaseReader::python_read_game() {
+    GameHeaders headers;
+    std::vector<Move> moves;
+    if (!read_game(headers, moves)) {
+        return boost::python::object();
+    }
+
+    boost::python::dict python_headers;
+    for (unsigned int i = 0; i < headers.size(); i++) {
+        python_headers[latin1_to_python(headers[i].first)] = latin1_to_python(headers[i].second);
+    }
+
+    boost::python::list python_moves;
+    for (unsigned int i = 0; i < moves.size(); i++) {
+        python_moves.append(moves[i]);
+    }
+
+    return boost::python::make_tuple(python_headers, python_moves);
+}
+
+} // namespace chess
@@ -0,0 +1,103 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_GAME_DATABASE_H
+#define LIBCHESS_GAME_DATABASE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/python.hpp>
+#include <boost/scoped_array.hpp>
+
+#include "uint.h"
+#include "move.h"
+#include "position.h"
+#include "pgn_parser.h"
+
+namespace chess {
+
+typedef std::vector<std::pair<std::string, std::string> > GameHeaders;
+
+/**
+ * \brief Writes games to a compact binary game database.
+ *
+ * The file starts with an 8 byte magic number. Then each game follows as
+ * a header block and a move block. The header block is the number of tag
+ * pairs and the length prefixed names and values. The move block is the
+ * number of plies and one byte per ply: the index of the move in the list
+ * generated by LegalMoveGenerator for the position. All numbers are
+ * unsigned LEB128 varints.
+ *
+ * Only the main line is stored. A `FEN` header sets the start position.
+ * Records are limited to 4096 headers, 64 KiB per name or value and 65536
+ * plies. Readers reject longer records as corrupt.
+ */
+class GameDatabaseWriter : boost::noncopyable {
+public:
+    GameDatabaseWriter(int fd);
+    ~GameDatabaseWriter();
+
+    void write_game(const GameHeaders& headers, const std::vector<Move>& moves);
+    int write_pgn(PgnParser& parser);
+    void flush();
+
+    void python_write_game(const boost::python::object& headers, const boost::python::object& moves);
+
+private:
+    class PgnConverter;
+
+    static int encode_move(Position& position, const Move& move);
+
+    void put_varint(uint64_t value);
+    void put_string(const std::string& str);
+    void write_record(const GameHeaders& headers, const std::vector<unsigned char>& plies);
+
+    int m_fd;
+    std::vector<char> m_buffer;
+};
+
+/**
+ * \brief Reads games from a binary game database written by
+ *   GameDatabaseWriter.
+ *
+ * The moves are decoded by generating the legal moves of each position,
+ * so no SAN has to be parsed.
+ */
+class GameDatabaseReader : boost::noncopyable {
+public:
+    GameDatabaseReader(int fd);
+
+    bool read_game(GameHeaders& headers, std::vector<Move>& moves);
+    boost::python::object python_read_game();
+
+    static const int BUFFER_SIZE = 64 * 1024;
+
+private:
+    bool fill();
+    bool get_byte(unsigned char& byte);
+    uint64_t get_varint();
+    void get_string(std::string& str);
+
+    int m_fd;
+    boost::scoped_array<char> m_buffer;
+    const char *m_position;
+    const char *m_end;
+};
+
+} // namespace chess
+
+#endif // LIBCHESS_GAME_DATABASE_H
@@ -14,98 +14,350 @@
 // You should have recieved a copy of the GNU General Public License
 // along with this program. If not, see <http://gnu.org/licenses/>.
 
+#include "libchess.h"
 #include "legal_move_generator.h"
 
 namespace chess {
 
 LegalMoveGenerator::LegalMoveGenerator(const Position& position) {
-    m_position = new Position(position);
-    m_pseudo_legal_moves = m_position->get_pseudo_legal_moves();
-    m_len = -1;
-    m_current = 0;
+    m_index = 0;
+    generate(position, m_moves);
 }
 
-LegalMoveGenerator::~LegalMoveGenerator() {
-    delete m_position;
-    delete m_pseudo_legal_moves;
+int LegalMoveGenerator::__len__() {
+    return m_moves.size();
 }
 
-int LegalMoveGenerator::__len__() {
-    if (m_len == -1) {
-	m_pseudo_legal_moves->__iter__();
+bool LegalMoveGenerator::__nonzero__() {
+    return !m_moves.empty();
+}
 
-	int counter = 0;
-	while (m_pseudo_legal_moves->has_more()) {
-	    if (would_be_valid_if_pseudo_legal(m_pseudo_legal_moves->next())) {
-		counter++;
-	    }
+LegalMoveGenerator& LegalMoveGenerator::__iter__() {
+    m_index = 0;
+    return *this;
+}
+
+bool LegalMoveGenerator::__contains__(const Move& move) {
+    return m_moves.contains(move);
+}
+
+Move LegalMoveGenerator::next() {
+    if (has_more()) {
+	return m_moves[m_index++];
+    } else {
+	throw std::logic_error("Called next() altough there are no more legal moves.");
+    }
+}
+
+Move LegalMoveGenerator::python_next() {
+    if (has_more()) {
+	return next();
+    } else {
+	PyErr_SetNone(PyExc_StopIteration);
+	throw boost::python::error_already_set();
+    }
+}
+
+bool LegalMoveGenerator::has_more() {
+    return m_index < m_moves.size();
+}
+
+int LegalMoveGenerator::generate(const Position& position, MoveList& moves) {
+    moves.clear();
+
+    char us = position.turn();
+    char them = opposite_color(us);
+    Bitboard own = position.occupied_co(us);
+    Bitboard occupied = position.occupied();
+
+    // Without a king any pseudo legal move is legal.
+    Bitboard king_mask = position.pieces('k', us);
+    int king = king_mask ? bb_lsb(king_mask) : -1;
+    Bitboard checkers = BB_VOID;
+    Bitboard pinned = BB_VOID;
+
+    if (king != -1) {
+	checkers = position.attackers_to(them, king, occupied);
+	pinned = pinned_pieces(position, king);
+    }
+
+    // In double check only the king can move. In single check the other
+    // pieces have to capture the checker or block the check.
+    Bitboard target_mask = ~own;
+    if (checkers) {
+	if (checkers & (checkers - 1)) {
+	    generate_king_moves(position, king, checkers, moves);
+	    return moves.size();
+	}
+	int checker = bb_lsb(checkers);
+	target_mask &= checkers | BB_BETWEEN[king][checker];
+    }
+
+    Bitboard sources = own;
+    while (sources) {
+	int square = bb_pop_lsb(sources);
+
+	// Pinned pieces can only move along the pin.
+	Bitboard allowed = target_mask;
+	if (pinned & bb_square(square)) {
+	    allowed &= BB_LINE[king][square];
 	}
-	m_len = counter;
 
-	m_pseudo_legal_moves->__iter__();
+	switch (position.get(Square(square)).type()) {
+	    case 'p':
+		generate_pawn_moves(position, square, allowed, king, moves);
+		break;
+	    case 'n':
+		push_moves(square, BB_KNIGHT_ATTACKS[square] & allowed, moves);
+		break;
+	    case 'b':
+		push_moves(square, bb_bishop_attacks(square, occupied) & allowed, moves);
+		break;
+	    case 'r':
+		push_moves(square, bb_rook_attacks(square, occupied) & allowed, moves);
+		break;
+	    case 'q':
+		push_moves(square, bb_queen_attacks(square, occupied) & allowed, moves);
+		break;
+	    case 'k':
+		generate_king_moves(position, square, checkers, moves);
+		break;
+	}
     }
-    return m_len;
+
+    return moves.size();
 }
 
-bool LegalMoveGenerator::__nonzero__() {
-    if (m_len == 0) {
+bool LegalMoveGenerator::has_legal_moves(const Position& position) {
+    char us = position.turn();
+    char them = opposite_color(us);
+    Bitboard own = position.occupied_co(us);
+    Bitboard occupied = position.occupied();
+    Bitboard king_mask = position.pieces('k', us);
+    MoveList moves;
+
+    // En-passant is rare and subtle, so such positions and positions
+    // without a king are decided by full generation.
+    if (!king_mask || position.get_ep_square().is_valid()) {
+	return generate(position, moves) > 0;
+    }
+
+    // Try king escapes first.
+    int king = bb_lsb(king_mask);
+    Bitboard without_king = occupied & ~king_mask;
+    Bitboard targets = BB_KING_ATTACKS[king] & ~own;
+    while (targets) {
+	if (!position.is_attacked(them, bb_pop_lsb(targets), without_king)) {
+	    return true;
+	}
+    }
+
+    Bitboard checkers = position.attackers_to(them, king, occupied);
+    if (checkers & (checkers - 1)) {
+	return false;
+    }
+
+    // A pinned piece can never capture or block a checker.
+    Bitboard pinned = pinned_pieces(position, king);
+    Bitboard pawns = position.pieces('p', us);
+    Bitboard movable = own & ~king_mask & ~pinned;
+
+    if (checkers) {
+	// Capture the checker.
+	int checker = bb_lsb(checkers);
+	if (position.attackers_to(us, checker, occupied) & movable) {
+	    return true;
+	}
+
+	// Block the check. Pawns can only block by pushing.
+	Bitboard blocks = BB_BETWEEN[king][checker];
+	while (blocks) {
+	    int square = bb_pop_lsb(blocks);
+	    if (position.attackers_to(us, square, occupied) & movable & ~pawns) {
+		return true;
+	    }
+
+	    Bitboard target = bb_square(square);
+	    Bitboard single = (us == 'w') ? bb_shift_down(target) : bb_shift_up(target);
+	    if (single & pawns & movable) {
+		return true;
+	    }
+
+	    // Double steps end on the fourth rank.
+	    if ((target & ((us == 'w') ? BB_RANK_4 : BB_RANK_5)) && !(single & occupied)) {
+		Bitboard origin = (us == 'w') ? bb_shift_down(single) : bb_shift_up(single);
+		if (origin & pawns & movable) {
+		    return true;
+		}
+	    }
+	}
+
 	return false;
     }
 
-    m_pseudo_legal_moves->__iter__();
+    // Not in check: Any move of a piece that is not pinned, or of a pinned
+    // piece along the pin, is legal. Double steps need not be considered,
+    // because they require the single step to be possible.
+    Bitboard sources = own & ~king_mask;
+    while (sources) {
+	int square = bb_pop_lsb(sources);
+	Bitboard allowed = ~own;
+	if (pinned & bb_square(square)) {
+	    allowed &= BB_LINE[king][square];
+	}
+
+	Bitboard attacks = BB_VOID;
+	switch (position.get(Square(square)).type()) {
+	    case 'p': {
+		int color_index = (us == 'w') ? 0 : 1;
+		Bitboard pawn = bb_square(square);
+		attacks = (((us == 'w') ? bb_shift_up(pawn) : bb_shift_down(pawn)) & ~occupied) |
+			  (BB_PAWN_ATTACKS[color_index][square] & position.occupied_co(them));
+		break;
+	    }
+	    case 'n':
+		attacks = BB_KNIGHT_ATTACKS[square];
+		break;
+	    case 'b':
+		attacks = bb_bishop_attacks(square, occupied);
+		break;
+	    case 'r':
+		attacks = bb_rook_attacks(square, occupied);
+		break;
+	    case 'q':
+		attacks = bb_queen_attacks(square, occupied);
+		break;
+	}
 
-    while (m_pseudo_legal_moves->has_more()) {
-	if (would_be_valid_if_pseudo_legal(m_pseudo_legal_moves->next())) {
+	if (attacks & allowed) {
 	    return true;
 	}
     }
 
-    m_len = 0;
+    // Castling requires a free king step, so it need not be considered.
     return false;
 }
 
-LegalMoveGenerator& LegalMoveGenerator::__iter__() {
-    m_current = 0;
-    m_pseudo_legal_moves->__iter__();
-    return *this;
-}
+Bitboard LegalMoveGenerator::pinned_pieces(const Position& position, int king) {
+    // Find own pieces that are the only blocker between the king and an
+    // opposing slider.
+    char them = opposite_color(position.turn());
+    Bitboard own = position.occupied_co(position.turn());
+    Bitboard occupied = position.occupied();
+    Bitboard queens = position.pieces('q', them);
+    Bitboard snipers = (bb_rook_attacks(king, BB_VOID) & (position.pieces('r', them) | queens)) |
+		       (bb_bishop_attacks(king, BB_VOID) & (position.pieces('b', them) | queens));
 
-bool LegalMoveGenerator::__contains__(const Move& move) {
-    if (!m_pseudo_legal_moves->__contains__(move)) {
-	return false;
-    } else {
-	return would_be_valid_if_pseudo_legal(move);
+    Bitboard pinned = BB_VOID;
+    while (snipers) {
+	Bitboard blockers = BB_BETWEEN[king][bb_pop_lsb(snipers)] & occupied;
+	if (blockers && !(blockers & (blockers - 1)) && (blockers & own)) {
+	    pinned |= blockers;
+	}
     }
+    return pinned;
 }
 
-Move LegalMoveGenerator::next() {
-    while (true) {
-	Move move = m_pseudo_legal_moves->next();
-	if (would_be_valid_if_pseudo_legal(move)) {
-	   m_current++;
-	   return move;
+void LegalMoveGenerator::generate_king_moves(const Position& position, int king, Bitboard checkers, MoveList& moves) {
+    char us = position.turn();
+    char them = opposite_color(us);
+    Bitboard occupied = position.occupied();
+
+    // The king may not step into an attack. It is removed from the
+    // occupancy so that it does not shadow sliders behind it.
+    Bitboard targets = BB_KING_ATTACKS[king] & ~position.occupied_co(us);
+    Bitboard without_king = occupied & ~bb_square(king);
+    while (targets) {
+	int target = bb_pop_lsb(targets);
+	if (!position.is_attacked(them, target, without_king)) {
+	    moves.push(Move(Square(king), Square(target)));
 	}
     }
+
+    // Castling is not possible out of check, through check or through
+    // other pieces.
+    int backrank = (us == 'w') ? 0 : 56;
+    if (checkers || king != backrank + 4) {
+	return;
+    }
+
+    if (position.has_kingside_castling_right(us) &&
+	position.could_have_kingside_castling_right(us) &&
+	!(occupied & (bb_square(backrank + 5) | bb_square(backrank + 6))) &&
+	!position.is_attacked(them, backrank + 5, occupied) &&
+	!position.is_attacked(them, backrank + 6, occupied))
+    {
+	moves.push(Move(Square(king), Square(backrank + 6)));
+    }
+
+    if (position.has_queenside_castling_right(us) &&
+	position.could_have_queenside_castling_right(us) &&
+	!(occupied & (bb_square(backrank + 1) | bb_square(backrank + 2) | bb_square(backrank + 3))) &&
+	!position.is_attacked(them, backrank + 3, occupied) &&
+	!position.is_attacked(them, backrank + 2, occupied))
+    {
+	moves.push(Move(Square(king), Square(backrank + 2)));
+    }
 }
 
-Move LegalMoveGenerator::python_next() {
-    while (true) {
-	Move move = m_pseudo_legal_moves->python_next();
-	if (would_be_valid_if_pseudo_legal(move)) {
-	    m_current++;
-	    return move;
+void LegalMoveGenerator::generate_pawn_moves(const Position& position, int square, Bitboard allowed, int king, MoveList& moves) {
+    char us = position.turn();
+    int color_index = (us == 'w') ? 0 : 1;
+    Bitboard occupied = position.occupied();
+
+    // Single steps forward.
+    Bitboard pawn = bb_square(square);
+    Bitboard single = ((us == 'w') ? bb_shift_up(pawn) : bb_shift_down(pawn)) & ~occupied;
+    if (single) {
+	if (single & allowed) {
+	    push_pawn_moves(square, bb_lsb(single), moves);
+	}
+
+	// Two steps forward. Blocking a check can be possible with the
+	// double step even if the single step does not.
+	Bitboard double_step = ((us == 'w') ?
+	    bb_shift_up(single & BB_RANK_3) :
+	    bb_shift_down(single & BB_RANK_6)) & ~occupied & allowed;
+	if (double_step) {
+	    moves.push(Move(Square(square), Square(bb_lsb(double_step))));
+	}
+    }
+
+    // Captures.
+    Bitboard targets = BB_PAWN_ATTACKS[color_index][square] &
+		       position.occupied_co(opposite_color(us)) & allowed;
+    while (targets) {
+	push_pawn_moves(square, bb_pop_lsb(targets), moves);
+    }
+
+    // En-passant. The capture removes two pieces from the same rank, so
+    // instead of relying on the pins the resulting occupancy is tested.
+    Square ep_square = position.get_ep_square();
+    if (ep_square.is_valid() && (BB_PAWN_ATTACKS[color_index][square] & bb_square(ep_square.index()))) {
+	int captured = Square(square / 8, ep_square.file()).index();
+	Bitboard after = (occupied & ~pawn & ~bb_square(captured)) | bb_square(ep_square.index());
+	if (king == -1 || !(position.attackers_to(opposite_color(us), king, after) & after)) {
+	    moves.push(Move(Square(square), ep_square));
 	}
     }
 }
 
-bool LegalMoveGenerator::has_more() {
-    return m_current < __len__();
+void LegalMoveGenerator::push_moves(int source, Bitboard targets, MoveList& moves) {
+    while (targets) {
+	moves.push(Move(Square(source), Square(bb_pop_lsb(targets))));
+    }
 }
 
-bool LegalMoveGenerator::would_be_valid_if_pseudo_legal(const Move& move) const {
-    Position position = Position(*m_position);
-    position.make_unvalidated_move_fast(move);
-    return !position.is_king_attacked(m_position->turn());
+void LegalMoveGenerator::push_pawn_moves(int source, int target, MoveList& moves) {
+    if (bb_square(target) & BB_BACKRANKS) {
+	// Promotion.
+	moves.push(Move(Square(source), Square(target), 'b'));
+	moves.push(Move(Square(source), Square(target), 'n'));
+	moves.push(Move(Square(source), Square(target), 'r'));
+	moves.push(Move(Square(source), Square(target), 'q'));
+    } else {
+	moves.push(Move(Square(source), Square(target)));
+    }
 }
 
 } // namespace chess
@@ -17,10 +17,10 @@
 #ifndef LIBCHESS_LEGAL_MOVE_GENERATOR_H
 #define LIBCHESS_LEGAL_MOVE_GENERATOR_H
 
-#include <boost/shared_ptr.hpp>
-
+#include "bitboard.h"
 #include "position.h"
-#include "pseudo_legal_move_generator.h"
+#include "move.h"
+#include "move_list.h"
 
 namespace chess {
 
@@ -28,11 +28,16 @@ class Position;
 
 /**
  * \brief Enumerates legal moves in a given position.
+ *
+ * Pinned pieces and checkers are computed once, so that only legal moves
+ * are generated and no moves have to be tried.
+ *
+ * The static generate() writes the moves into a MoveList provided by the
+ * caller, so that hot loops do not need to allocate anything.
  */
 class LegalMoveGenerator : boost::noncopyable {
 public:
     LegalMoveGenerator(const Position& position);
-    ~LegalMoveGenerator();
 
     int __len__();
     bool __nonzero__();
@@ -43,13 +48,18 @@ public:
     Move python_next();
     bool has_more();
 
+    static int generate(const Position& position, MoveList& moves);
+    static bool has_legal_moves(const Position& position);
+
 private:
-    bool would_be_valid_if_pseudo_legal(const Move& move) const;
+    static Bitboard pinned_pieces(const Position& position, int king);
+    static void generate_king_moves(const Position& position, int king, Bitboard checkers, MoveList& moves);
+    static void generate_pawn_moves(const Position& position, int square, Bitboard allowed, int king, MoveList& moves);
+    static void push_moves(int source, Bitboard targets, MoveList& moves);
+    static void push_pawn_moves(int source, int target, MoveList& moves);
 
-    Position* m_position;
-    PseudoLegalMoveGenerator* m_pseudo_legal_moves;
-    int m_len;
-    int m_current;
+    MoveList m_moves;
+    int m_index;
 };
 
 } // namespace chess
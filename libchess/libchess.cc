@@ -109,6 +109,7 @@ class_<Move>("Move", init<const Square&, const Square&>())
     .add_property("promotion", &Move::promotion)
     .add_property("full_promotion", &Move::full_promotion)
     .add_property("uci", &Move::uci)
+    .add_property("raw", &Move::raw)
     .def("is_promotion", &Move::is_promotion)
     .def(self == other<Move>())
     .def(self != other<Move>())
@@ -116,7 +117,9 @@ class_<Move>("Move", init<const Square&, const Square&>())
     .def("__repr__", &Move::__repr__)
     .def("__hash__", &Move::__hash__)
     .def("from_uci", &Move::from_uci)
-    .staticmethod("from_uci");
+    .staticmethod("from_uci")
+    .def("from_raw", &Move::from_raw)
+    .staticmethod("from_raw");
 
 class_<MoveInfo>("MoveInfo", init<const Move&, const Piece&>())
     .def(init<const MoveInfo&>())
@@ -145,6 +148,8 @@ class_<Position>("Position")
     .def("get_pseudo_legal_moves", &Position::get_pseudo_legal_moves, return_value_policy<manage_new_object>())
     .def("get_legal_moves", &Position::get_legal_moves, return_value_policy<manage_new_object>())
     .def("get_attackers", &Position::get_attackers, return_value_policy<manage_new_object>())
+    .def("attackers_to", (Bitboard (Position::*)(char, const Square&) const) &Position::attackers_to)
+    .def("is_attacked", (bool (Position::*)(char, const Square&) const) &Position::is_attacked)
     .def("get_king", &Position::python_get_king)
     .def("is_king_attacked", &Position::is_king_attacked)
     .def("is_check", &Position::is_check)
@@ -160,9 +165,17 @@ class_<Position>("Position")
     .def("could_have_queenside_castling_right", &Position::could_have_queenside_castling_right)
     .def("make_move", &Position::make_move)
     .def("make_move_fast", &Position::make_move_fast)
-    .def("get_move_from_san", &Position::get_move_from_san)
+    .def("make_move_from_san_fast", &Position::make_move_from_san_fast)
+    .def("san", (std::string (Position::*)(const Move&) const) &Position::san)
+    .def("get_move_from_san", (Move (Position::*)(const std::string&) const) &Position::get_move_from_san)
     .def("make_move_from_san", &Position::make_move_from_san)
-    .add_property("fen", &Position::fen, &Position::set_fen)
+    .def("replay_san", &Position::python_replay_san, (arg("sans"), arg("hashes") = false))
+    .def("replay_uci", &Position::python_replay_uci, (arg("ucis"), arg("hashes") = false))
+    .def("unmake_move", &Position::unmake_move)
+    .def("perft", &Position::perft)
+    .def("parallel_perft", &Position::python_parallel_perft, (arg("depth"), arg("threads") = 0, arg("hash_megabytes") = 0))
+    .def("divide", &Position::python_divide)
+    .add_property("fen", &Position::fen, (void (Position::*)(const std::string&)) &Position::set_fen)
     .def(self == other<Position>())
     .def(self != other<Position>())
     .def(self_ns::str(self))
@@ -202,4 +215,78 @@ class_<PolyglotOpeningBookEntry>("PolyglotOpeningBookEntry", init<const Position
     .add_property("weight", &PolyglotOpeningBookEntry::weight, &PolyglotOpeningBookEntry::set_weight)
     .add_property("learn", &PolyglotOpeningBookEntry::learn, &PolyglotOpeningBookEntry::set_learn);
 
+class_<PolyglotBookRange>("PolyglotBookRange", no_init)
+    .def("__len__", &PolyglotBookRange::__len__)
+    .def("__getitem__", &PolyglotBookRange::__getitem__);
+
+class_<PolyglotBook, boost::noncopyable>("PolyglotBook", init<const std::string&>())
+    .def("__len__", &PolyglotBook::__len__)
+    .def("__getitem__", &PolyglotBook::__getitem__)
+    .def("lower_bound", &PolyglotBook::lower_bound)
+    .def("find_key", &PolyglotBook::find_key, with_custodian_and_ward_postcall<0, 1>())
+    .def("find", &PolyglotBook::find, with_custodian_and_ward_postcall<0, 1>())
+    .def("load_into_memory", &PolyglotBook::load_into_memory)
+    .add_property("is_loaded_into_memory", &PolyglotBook::is_loaded_into_memory);
+
+class_<PolyglotBookBuilder, boost::noncopyable>("PolyglotBookBuilder", init<const std::string&, int, int, int, int>((arg("path"), arg("max_ply") = 40, arg("threads") = 0, arg("memory_megabytes") = 256, arg("max_runs") = (int) PolyglotBookBuilder::MAX_RUNS)))
+    .def("add_pgn", &PolyglotBookBuilder::python_add_pgn)
+    .def("finish", &PolyglotBookBuilder::python_finish);
+
+class_<PolyglotBookMerger, boost::noncopyable>("PolyglotBookMerger", init<const std::string&, int, int>((arg("policy") = "sum", arg("min_weight") = 0, arg("max_depth") = -1)))
+    .def("add_book", &PolyglotBookMerger::add_book)
+    .def("merge", &PolyglotBookMerger::python_merge);
+
+class_<PythonPgnVisitor, boost::noncopyable>("PgnVisitor")
+    .def("begin_game", &PgnVisitor::begin_game, &PythonPgnVisitor::default_begin_game)
+    .def("header", &PgnVisitor::header, &PythonPgnVisitor::default_header)
+    .def("end_headers", &PgnVisitor::end_headers, &PythonPgnVisitor::default_end_headers)
+    .def("san", &PgnVisitor::san, &PythonPgnVisitor::default_san)
+    .def("move", &PgnVisitor::move, &PythonPgnVisitor::default_move)
+    .def("nag", &PgnVisitor::nag, &PythonPgnVisitor::default_nag)
+    .def("comment", &PgnVisitor::comment, &PythonPgnVisitor::default_comment)
+    .def("begin_variation", &PgnVisitor::begin_variation, &PythonPgnVisitor::default_begin_variation)
+    .def("end_variation", &PgnVisitor::end_variation, &PythonPgnVisitor::default_end_variation)
+    .def("result", &PgnVisitor::result, &PythonPgnVisitor::default_result)
+    .def("end_game", &PgnVisitor::end_game, &PythonPgnVisitor::default_end_game)
+    .def("error", &PgnVisitor::error, &PythonPgnVisitor::default_error);
+
+class_<PgnParser, boost::noncopyable>("PgnParser", init<int>())
+    .def(init<const std::string&>())
+    .def("parse_game", &PgnParser::parse_game)
+    .def("parse", &PgnParser::parse)
+    .def("parse_headers", &PgnParser::parse_headers)
+    .def("read_headers", &PgnParser::python_read_headers)
+    .def("tell", &PgnParser::tell)
+    .add_property("game_offset", &PgnParser::game_offset)
+    .add_property("game_length", &PgnParser::game_length);
+
+class_<ParallelPgnParser, boost::noncopyable>("ParallelPgnParser", init<int, int, int>((arg("fd"), arg("threads") = 0, arg("chunk_size") = (int) PgnChunkReader::CHUNK_SIZE)))
+    .def("parse", &ParallelPgnParser::python_parse);
+
+class_<PgnIndexEntry>("PgnIndexEntry")
+    .add_property("offset", &PgnIndexEntry::offset)
+    .add_property("length", &PgnIndexEntry::length)
+    .add_property("year", &PgnIndexEntry::year)
+    .add_property("month", &PgnIndexEntry::month)
+    .add_property("day", &PgnIndexEntry::day)
+    .add_property("date", &PgnIndexEntry::date)
+    .add_property("result", &PgnIndexEntry::result)
+    .add_property("eco", &PgnIndexEntry::eco)
+    .add_property("white_elo", &PgnIndexEntry::white_elo)
+    .add_property("black_elo", &PgnIndexEntry::black_elo);
+
+class_<PgnIndex, boost::noncopyable>("PgnIndex", init<const std::string&>())
+    .def("update", &PgnIndex::update)
+    .def("__len__", &PgnIndex::__len__)
+    .def("__getitem__", &PgnIndex::__getitem__, return_value_policy<copy_const_reference>())
+    .def("parse_game", &PgnIndex::parse_game);
+
+class_<GameDatabaseWriter, boost::noncopyable>("GameDatabaseWriter", init<int>())
+    .def("write_game", &GameDatabaseWriter::python_write_game)
+    .def("write_pgn", &GameDatabaseWriter::write_pgn)
+    .def("flush", &GameDatabaseWriter::flush);
+
+class_<GameDatabaseReader, boost::noncopyable>("GameDatabaseReader", init<int>())
+    .def("read_game", &GameDatabaseReader::python_read_game);
+
 } // BOOST_PYTHON_MODULE(libchess)
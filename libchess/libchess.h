@@ -62,7 +62,7 @@
  *   \endcode
  *
  * \section Building
- * cmake, libboost-regex-dev and libboost-python-dev are required.
+ * cmake, libboost-python-dev and libboost-thread-dev are required.
  * \code
  * cmake .
  * make
@@ -85,15 +85,25 @@
 #ifndef LIBCHESS_LIBCHESS_H
 #define LIBCHESS_LIBCHESS_H
 
+#include "bitboard.h"
 #include "piece.h"
 #include "square.h"
 #include "move.h"
+#include "move_list.h"
 #include "move_info.h"
 #include "attacker_generator.h"
 #include "legal_move_generator.h"
 #include "pseudo_legal_move_generator.h"
 #include "position.h"
+#include "perft.h"
+#include "pgn_parser.h"
+#include "parallel_pgn_parser.h"
+#include "pgn_index.h"
+#include "game_database.h"
 #include "polyglot_opening_book_entry.h"
+#include "polyglot_book.h"
+#include "polyglot_book_builder.h"
+#include "polyglot_book_merger.h"
 
 namespace chess {
 
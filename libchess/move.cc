@@ -20,7 +20,18 @@
 
 namespace chess {
 
-Move::Move(const Square& source, const Square& target, char promotion) : m_source(source), m_target(target) {
+namespace {
+
+// Promotion piece types by their code in the packed move.
+const char PROMOTION_TYPES[8] = { 0, 'n', 'b', 'r', 'q', 0, 0, 0 };
+
+} // anonymous namespace
+
+Move::Move() {
+    m_raw = 0;
+}
+
+Move::Move(const Square& source, const Square& target, char promotion) {
     if (!source.is_valid()) {
         throw std::invalid_argument("source");
     }
@@ -29,19 +40,15 @@ Move::Move(const Square& source, const Square& target, char promotion) : m_sourc
         throw std::invalid_argument("target");
     }
 
-    switch (promotion) {
-        case 'r':
-        case 'n':
-        case 'b':
-        case 'q':
-            m_promotion = promotion;
-            break;
-        default:
-            throw std::invalid_argument("promotion");
+    uint16_t code = promotion_code(promotion);
+    if (!code) {
+        throw std::invalid_argument("promotion");
     }
+
+    m_raw = target.index() | (source.index() << 6) | (code << 12);
 }
 
-Move::Move(const Square& source, const Square& target) : m_source(source), m_target(target) {
+Move::Move(const Square& source, const Square& target) {
     if (!source.is_valid()) {
         throw std::invalid_argument("source");
     }
@@ -50,27 +57,20 @@ Move::Move(const Square& source, const Square& target) : m_source(source), m_tar
         throw std::invalid_argument("target");
     }
 
-
-    m_promotion = 0;
+    m_raw = target.index() | (source.index() << 6);
 }
 
-Move::Move(const std::string& uci) : m_source(Square(0)), m_target(Square(0)) {
+Move::Move(const std::string& uci) {
     if (uci.length() == 4 || uci.length() == 5) {
-        m_source = Square(uci.substr(0, 2));
-        m_target = Square(uci.substr(2, 2));
+        Square source(uci.substr(0, 2));
+        Square target(uci.substr(2, 2));
+        m_raw = target.index() | (source.index() << 6);
         if (uci.length() == 5) {
-            m_promotion = uci.at(4);
-            switch (m_promotion) {
-                case 'r':
-                case 'n':
-                case 'b':
-                case 'q':
-                    break;
-                default:
-                    throw std::invalid_argument("uci");
+            uint16_t code = promotion_code(uci.at(4));
+            if (!code) {
+                throw std::invalid_argument("uci");
             }
-        } else {
-            m_promotion = 0;
+            m_raw |= code << 12;
         }
     }
     else {
@@ -78,26 +78,20 @@ Move::Move(const std::string& uci) : m_source(Square(0)), m_target(Square(0)) {
     }
 }
 
-Move::Move(const Move& move) {
-    m_source = move.m_source;
-    m_target = move.m_target;
-    m_promotion = move.m_promotion;
-}
-
 Square Move::source() const {
-    return m_source;
+    return Square((m_raw >> 6) & 0x3f);
 }
 
 Square Move::target() const {
-    return m_target;
+    return Square(m_raw & 0x3f);
 }
 
 char Move::promotion() const {
-    return m_promotion;
+    return PROMOTION_TYPES[(m_raw >> 12) & 0x7];
 }
 
 std::string Move::full_promotion() const {
-    switch (m_promotion) {
+    switch (promotion()) {
         case 'r':
             return "rook";
         case 'b':
@@ -112,15 +106,19 @@ std::string Move::full_promotion() const {
 }
 
 std::string Move::uci() const {
-    if (m_promotion) {
-        return m_source.name() + m_target.name() + m_promotion;
+    if (is_promotion()) {
+        return source().name() + target().name() + promotion();
     } else {
-        return m_source.name() + m_target.name();
+        return source().name() + target().name();
     }
 }
 
 bool Move::is_promotion() const {
-    return m_promotion != 0;
+    return (m_raw >> 12) & 0x7;
+}
+
+uint16_t Move::raw() const {
+    return m_raw;
 }
 
 std::string Move::__repr__() const {
@@ -128,28 +126,46 @@ std::string Move::__repr__() const {
 }
 
 int Move::__hash__() const {
-    return m_source.__hash__() + 100 * m_target.__hash__() + 10000 * m_promotion;
-}
-
-Move& Move::operator=(const Move& rhs) {
-    m_source = rhs.m_source;
-    m_target = rhs.m_target;
-    m_promotion = rhs.m_promotion;
-    return *this;
+    return (m_raw >> 6 & 0x3f) + 100 * (m_raw & 0x3f) + 10000 * promotion();
 }
 
 bool Move::operator==(const Move& rhs) const {
-    return m_source == rhs.m_source && m_target == rhs.m_target && m_promotion == rhs.m_promotion;
+    return m_raw == rhs.m_raw;
 }
 
 bool Move::operator!=(const Move& rhs) const {
-    return m_source != rhs.m_source || m_target != rhs.m_target || m_promotion != rhs.m_promotion;
+    return m_raw != rhs.m_raw;
 }
 
 Move Move::from_uci(const std::string& uci) {
     return Move(uci);
 }
 
+Move Move::from_raw(uint16_t raw) {
+    if (raw >> 12 > 4) {
+        throw std::invalid_argument("raw");
+    }
+
+    Move move;
+    move.m_raw = raw;
+    return move;
+}
+
+uint16_t Move::promotion_code(char promotion) {
+    switch (promotion) {
+        case 'n':
+            return 1;
+        case 'b':
+            return 2;
+        case 'r':
+            return 3;
+        case 'q':
+            return 4;
+        default:
+            return 0;
+    }
+}
+
 std::ostream& operator<<(std::ostream& out, const Move& move) {
     out << move.uci();
     return out;
@@ -17,6 +17,7 @@
 #ifndef LIBCHESS_MOVE_H
 #define LIBCHESS_MOVE_H
 
+#include "uint.h"
 #include "square.h"
 
 #include <iostream>
@@ -25,13 +26,18 @@ namespace chess {
 
 /**
  * \brief An immutable move.
+ *
+ * The move is packed into 16 bits in the same layout as Polyglot opening
+ * books use: the target square in bits 0 to 5, the source square in bits
+ * 6 to 11 and the promotion piece type in bits 12 to 14. The default
+ * constructed move has all bits cleared.
  */
 class Move {
 public:
+    Move();
     Move(const Square& source, const Square& target, char promotion);
     Move(const Square& source, const Square& target);
     Move(const std::string& uci);
-    Move(const Move& move);
 
     Square source() const;
     Square target() const;
@@ -40,20 +46,21 @@ public:
     std::string uci() const;
 
     bool is_promotion() const;
+    uint16_t raw() const;
 
     std::string __repr__() const;
     int __hash__() const;
 
-    Move& operator=(const Move& rhs);
     bool operator==(const Move& rhs) const;
     bool operator!=(const Move& rhs) const;
 
     static Move from_uci(const std::string& uci);
+    static Move from_raw(uint16_t raw);
 
 private:
-    Square m_source;
-    Square m_target;
-    char m_promotion;
+    static uint16_t promotion_code(char promotion);
+
+    uint16_t m_raw;
 };
 
 std::ostream& operator<<(std::ostream &out, const Move& move);
@@ -15,6 +15,7 @@
 // along with this program. If not, see <http://gnu.org/licenses/>.
 
 #include "move_info.h"
+#include "position.h"
 
 namespace chess {
 
@@ -29,14 +30,31 @@ MoveInfo::MoveInfo(const Move& move, const Piece& piece) : m_move(move), m_piece
     m_is_queenside_castle = false;
     m_is_check = false;
     m_is_checkmate = false;
+
+    m_lazy = false;
+    m_previous_turn = 0;
+
+    m_has_undo_state = false;
+    m_previous_castling_rights = 0;
+    m_previous_ep_file = 0;
+    m_previous_half_moves = 0;
+    m_previous_hash = 0;
 }
 
 MoveInfo::MoveInfo(const MoveInfo& move_info) : m_move(move_info.m_move), m_piece(move_info.m_piece), m_captured(move_info.m_captured), m_san(move_info.m_san) {
+    copy_snapshot(move_info);
+
     m_is_enpassant = move_info.m_is_enpassant;
     m_is_kingside_castle = move_info.m_is_kingside_castle;
     m_is_queenside_castle = move_info.m_is_queenside_castle;
     m_is_check = move_info.m_is_check;
     m_is_checkmate = move_info.m_is_checkmate;
+
+    m_has_undo_state = move_info.m_has_undo_state;
+    m_previous_castling_rights = move_info.m_previous_castling_rights;
+    m_previous_ep_file = move_info.m_previous_ep_file;
+    m_previous_half_moves = move_info.m_previous_half_moves;
+    m_previous_hash = move_info.m_previous_hash;
 }
 
 Move MoveInfo::move() const {
@@ -44,6 +62,7 @@ Move MoveInfo::move() const {
 }
 
 void MoveInfo::set_move(const Move& move) {
+    compute_lazy_fields();
     m_move = move;
 }
 
@@ -52,7 +71,8 @@ Piece MoveInfo::piece() const {
 }
 
 void MoveInfo::set_piece(const Piece& piece) {
-     m_piece = piece;
+    compute_lazy_fields();
+    m_piece = piece;
 }
 
 Piece MoveInfo::captured() const {
@@ -68,10 +88,12 @@ boost::python::object MoveInfo::python_captured() const {
 }
 
 void MoveInfo::set_captured(const Piece& captured) {
+    compute_lazy_fields();
     m_captured = captured;
 }
 
 void MoveInfo::python_set_captured(const boost::python::object& captured) {
+    compute_lazy_fields();
     if (captured.ptr() == Py_None) {
 	m_captured = Piece();
     } else {
@@ -84,6 +106,7 @@ bool MoveInfo::is_enpassant() const {
 }
 
 void MoveInfo::set_is_enpassant(bool is_enpassant) {
+    compute_lazy_fields();
     m_is_enpassant = is_enpassant;
 }
 
@@ -92,6 +115,7 @@ bool MoveInfo::is_kingside_castle() const {
 }
 
 void MoveInfo::set_is_kingside_castle(bool is_kingside_castle) {
+    compute_lazy_fields();
     m_is_kingside_castle = is_kingside_castle;
 }
 
@@ -100,37 +124,97 @@ bool MoveInfo::is_queenside_castle() const {
 }
 
 void MoveInfo::set_is_queenside_castle(bool is_queenside_castle) {
+    compute_lazy_fields();
     m_is_queenside_castle = is_queenside_castle;
 }
 
 bool MoveInfo::is_castle() const {
-    return m_is_kingside_castle || m_is_kingside_castle;
+    return m_is_kingside_castle || m_is_queenside_castle;
 }
 
 bool MoveInfo::is_check() const {
+    compute_lazy_fields();
     return m_is_check;
 }
 
 void MoveInfo::set_is_check(bool is_check) {
+    compute_lazy_fields();
     m_is_check = is_check;
 }
 
 bool MoveInfo::is_checkmate() const {
+    compute_lazy_fields();
     return m_is_checkmate;
 }
 
 void MoveInfo::set_is_checkmate(bool is_checkmate) {
+    compute_lazy_fields();
     m_is_checkmate = is_checkmate;
 }
 
 std::string MoveInfo::san() const {
+    compute_lazy_fields();
     return m_san;
 }
 
 void MoveInfo::set_san(const std::string& san) {
+    compute_lazy_fields();
     m_san = san;
 }
 
+void MoveInfo::copy_snapshot(const MoveInfo& move_info) {
+    m_lazy = move_info.m_lazy;
+    m_previous_turn = move_info.m_previous_turn;
+    if (m_lazy) {
+	for (int i = 0; i < 2; i++) {
+	    m_previous_occupied_co[i] = move_info.m_previous_occupied_co[i];
+	}
+	for (int i = 0; i < 6; i++) {
+	    m_previous_pieces[i] = move_info.m_previous_pieces[i];
+	}
+    }
+}
+
+void MoveInfo::compute_lazy_fields() const {
+    if (!m_lazy) {
+	return;
+    }
+
+    // Rebuild the position before the move.
+    Position previous;
+    for (int i = 0; i < 64; i++) {
+	previous.m_mailbox[i] = Piece();
+    }
+    for (int color = 0; color < 2; color++) {
+	previous.m_occupied_co[color] = m_previous_occupied_co[color];
+	for (int type = 0; type < 6; type++) {
+	    Bitboard pieces = m_previous_pieces[type] & m_previous_occupied_co[color];
+	    while (pieces) {
+		previous.m_mailbox[bb_pop_lsb(pieces)] = Piece::from_color_and_type(color ? 'b' : 'w', "pnbrqk"[type]);
+	    }
+	}
+    }
+    for (int type = 0; type < 6; type++) {
+	previous.m_pieces[type] = m_previous_pieces[type];
+    }
+    previous.m_turn = m_previous_turn;
+    previous.m_ep_file = m_previous_ep_file;
+    previous.m_half_moves = m_previous_half_moves;
+    previous.m_white_castle_kingside = m_previous_castling_rights & 1;
+    previous.m_white_castle_queenside = m_previous_castling_rights & 2;
+    previous.m_black_castle_kingside = m_previous_castling_rights & 4;
+    previous.m_black_castle_queenside = m_previous_castling_rights & 8;
+    previous.m_hash = m_previous_hash;
+
+    Position position(previous);
+    position.make_unvalidated_move_fast(m_move);
+    m_is_check = position.is_check();
+    m_is_checkmate = m_is_check && position.is_checkmate();
+    m_san = previous.san(m_move, m_is_check, m_is_checkmate);
+
+    m_lazy = false;
+}
+
 MoveInfo& MoveInfo::operator=(const MoveInfo& rhs) {
     m_move = rhs.m_move;
     m_piece = rhs.m_piece;
@@ -141,6 +225,13 @@ MoveInfo& MoveInfo::operator=(const MoveInfo& rhs) {
     m_is_check = rhs.m_is_check;
     m_is_checkmate = rhs.m_is_checkmate;
     m_san = rhs.m_san;
+    copy_snapshot(rhs);
+
+    m_has_undo_state = rhs.m_has_undo_state;
+    m_previous_castling_rights = rhs.m_previous_castling_rights;
+    m_previous_ep_file = rhs.m_previous_ep_file;
+    m_previous_half_moves = rhs.m_previous_half_moves;
+    m_previous_hash = rhs.m_previous_hash;
 
     return *this;
 }
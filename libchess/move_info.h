@@ -19,13 +19,24 @@
 
 #include <boost/python.hpp>
 
+#include "uint.h"
+#include "bitboard.h"
 #include "piece.h"
 #include "move.h"
 
 namespace chess {
 
+class Position;
+
 /**
  * \brief Information about a move made in a position.
+ *
+ * Position::make_move() leaves the bitboards of the position before the
+ * move in the move info. Together with the state kept for
+ * Position::unmake_move() they are enough to rebuild the position, and
+ * the check flags and the SAN are computed from it when one of them is
+ * accessed first. All setters compute them before changing anything, so
+ * they always describe the move as it was made.
  */
 class MoveInfo {
 public:
@@ -66,15 +77,36 @@ public:
     MoveInfo& operator=(const MoveInfo& rhs);
 
 private:
+    friend class Position;
+
+    void copy_snapshot(const MoveInfo& move_info);
+    void compute_lazy_fields() const;
+
     Move m_move;
     Piece m_piece;
     Piece m_captured;
     bool m_is_enpassant;
     bool m_is_kingside_castle;
     bool m_is_queenside_castle;
-    bool m_is_check;
-    bool m_is_checkmate;
-    std::string m_san;
+    mutable bool m_is_check;
+    mutable bool m_is_checkmate;
+    mutable std::string m_san;
+
+    // The board before the move, as long as the check flags and the SAN
+    // have not been computed.
+    mutable bool m_lazy;
+    char m_previous_turn;
+    Bitboard m_previous_occupied_co[2];
+    Bitboard m_previous_pieces[6];
+
+    // The state of the position before the move, so that
+    // Position::unmake_move() can restore it. Only move infos returned by
+    // Position::make_move() have it.
+    bool m_has_undo_state;
+    unsigned char m_previous_castling_rights;
+    char m_previous_ep_file;
+    int m_previous_half_moves;
+    uint64_t m_previous_hash;
 };
 
 } // namespace chess
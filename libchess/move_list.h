@@ -0,0 +1,81 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_MOVE_LIST_H
+#define LIBCHESS_MOVE_LIST_H
+
+#include <stdexcept>
+
+#include "move.h"
+
+namespace chess {
+
+/**
+ * \brief A list of moves with a fixed capacity, so that it can live on the
+ *   stack and filling it does not allocate.
+ *
+ * The capacity is enough for the moves of any reachable position.
+ */
+class MoveList {
+public:
+    static const int CAPACITY = 256;
+
+    MoveList() : m_size(0) { }
+
+    void push(const Move& move) {
+        if (m_size == CAPACITY) {
+            throw std::logic_error("Move list is full.");
+        }
+        m_moves[m_size++] = move;
+    }
+
+    void clear() {
+        m_size = 0;
+    }
+
+    int size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    const Move& operator[](int index) const {
+        return m_moves[index];
+    }
+
+    bool contains(const Move& move) const {
+        return index_of(move) >= 0;
+    }
+
+    int index_of(const Move& move) const {
+        for (int i = 0; i < m_size; i++) {
+            if (m_moves[i] == move) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+private:
+    Move m_moves[CAPACITY];
+    int m_size;
+};
+
+} // namespace chess
+
+#endif // LIBCHESS_MOVE_LIST_H
@@ -0,0 +1,410 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <unistd.h>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "libchess.h"
+#include "parallel_pgn_parser.h"
+
+namespace chess {
+
+namespace {
+
+// Without an `[Event` tag the pending data is cut before any tag pair
+// once it holds this many chunks.
+const int MAX_PENDING_CHUNKS = 2;
+
+// Finds the start of the last tag that follows a blank line and starts at
+// or after from, or 0.
+std::string::size_type last_game_boundary(const std::string& data, std::string::size_type from, const char *tag) {
+    std::string::size_type start = data.rfind(tag);
+
+    while (start != std::string::npos && start > 0 && start >= from) {
+        std::string::size_type end = start;
+        if (data[end - 1] == '\n') {
+            end--;
+            if (end > 0 && data[end - 1] == '\r') {
+                end--;
+            }
+            if (end == 0 || data[end - 1] == '\n') {
+                return start;
+            }
+        }
+
+        start = data.rfind(tag, start - 1);
+    }
+
+    return 0;
+}
+
+} // anonymous namespace
+
+GilRelease::GilRelease(bool release) : m_state(release ? PyEval_SaveThread() : NULL) { }
+
+GilRelease::~GilRelease() {
+    if (m_state) {
+        PyEval_RestoreThread(m_state);
+    }
+}
+
+PgnChunkReader::PgnChunkReader(int fd, int chunk_size)
+    : m_fd(fd), m_chunk_size(chunk_size), m_eof(false), m_tag_searched(0)
+{
+    if (chunk_size <= 0) {
+        throw new std::invalid_argument("chunk_size");
+    }
+}
+
+bool PgnChunkReader::read_chunk(std::string& data) {
+    while (!m_eof) {
+        std::string::size_type start = m_pending.length();
+        m_pending.resize(start + m_chunk_size);
+
+        ssize_t length;
+        do {
+            length = read(m_fd, &m_pending[start], m_chunk_size);
+        } while (length < 0 && errno == EINTR);
+
+        m_pending.resize(start + std::max((ssize_t) 0, length));
+        if (length < 0) {
+            throw new std::invalid_argument("fd");
+        } else if (length == 0) {
+            m_eof = true;
+            break;
+        }
+
+        // Cut the data read so far before the last game. The data read
+        // before has no boundary, so only an `[Event` tag that ends in the
+        // new data has to be looked for.
+        std::string::size_type boundary = last_game_boundary(m_pending, start > 5 ? start - 5 : 0, "[Event");
+        bool tag_searched = false;
+        if (!boundary && m_pending.length() >= (std::string::size_type) MAX_PENDING_CHUNKS * m_chunk_size) {
+            boundary = last_game_boundary(m_pending, m_tag_searched, "[");
+            tag_searched = true;
+        }
+
+        if (boundary > 0) {
+            data.assign(m_pending, 0, boundary);
+            m_pending.erase(0, boundary);
+            m_tag_searched = tag_searched ? m_pending.length() : 0;
+            return true;
+        } else if (tag_searched) {
+            m_tag_searched = m_pending.length();
+        }
+    }
+
+    // The rest of the file.
+    data.swap(m_pending);
+    m_pending.clear();
+    m_tag_searched = 0;
+    return !data.empty();
+}
+
+/**
+ * \brief Records the tokens of a chunk and plays out the moves.
+ */
+class ParallelPgnParser::RecordingVisitor : public PgnVisitor {
+public:
+    RecordingVisitor(std::vector<Event>& events) : m_events(events) { }
+
+    void begin_game() {
+        record(Event::BEGIN_GAME);
+        m_fen.clear();
+        m_valid = true;
+    }
+
+    void header(const std::string& name, const std::string& value) {
+        record(Event::HEADER, name, value);
+        if (name == "FEN") {
+            m_fen = value;
+        }
+    }
+
+    void end_headers() {
+        record(Event::END_HEADERS);
+
+        m_positions.clear();
+        m_previous.clear();
+        m_positions.push_back(Position());
+        m_previous.push_back(Position());
+        if (!m_fen.empty()) {
+            try {
+                m_positions.back().set_fen(m_fen.c_str(), m_fen.length());
+            } catch (const std::invalid_argument& e) {
+                error("invalid fen: " + m_fen);
+            } catch (std::invalid_argument *e) {
+                delete e;
+                error("invalid fen: " + m_fen);
+            }
+        }
+    }
+
+    void san(const std::string& san) {
+        if (!m_valid) {
+            record(Event::SAN, san);
+            return;
+        }
+
+        Move move;
+        try {
+            move = m_positions.back().get_move_from_san(san.c_str(), san.length());
+        } catch (const std::invalid_argument& e) {
+            record(Event::SAN, san);
+            error("illegal san: " + san);
+            return;
+        } catch (std::invalid_argument *e) {
+            delete e;
+            record(Event::SAN, san);
+            error("illegal san: " + san);
+            return;
+        }
+
+        // Keep the resolved move, so that the SAN is not parsed again.
+        record(Event::MOVE, san).move = move;
+        m_previous.back() = m_positions.back();
+        play(m_positions.back(), move);
+    }
+
+    void nag(int nag) {
+        Event& event = record(Event::NAG);
+        event.nag = nag;
+    }
+
+    void comment(const std::string& comment) {
+        record(Event::COMMENT, comment);
+    }
+
+    void begin_variation() {
+        record(Event::BEGIN_VARIATION);
+
+        // The variation replaces the last move.
+        m_positions.push_back(m_previous.back());
+        m_previous.push_back(m_previous.back());
+    }
+
+    void end_variation() {
+        record(Event::END_VARIATION);
+        m_positions.pop_back();
+        m_previous.pop_back();
+    }
+
+    void result(const std::string& result) {
+        record(Event::RESULT, result);
+    }
+
+    void end_game() {
+        record(Event::END_GAME);
+    }
+
+    void error(const std::string& message) {
+        record(Event::ERROR, message);
+
+        // Do not report follow-up errors.
+        m_valid = false;
+    }
+
+private:
+    Event& record(Event::Type type, const std::string& first = std::string(), const std::string& second = std::string()) {
+        m_events.push_back(Event());
+        Event& event = m_events.back();
+        event.type = type;
+        event.nag = 0;
+        event.first = first;
+        event.second = second;
+        return event;
+    }
+
+    std::vector<Event>& m_events;
+    std::vector<Position> m_positions;
+    std::vector<Position> m_previous;
+    std::string m_fen;
+    bool m_valid;
+};
+
+ParallelPgnParser::ParallelPgnParser(int fd, int threads, int chunk_size)
+    : m_reader(fd, chunk_size), m_release_gil(false), m_stopped(false)
+{
+    if (threads < 0) {
+        throw new std::invalid_argument("threads");
+    }
+
+    m_threads = threads ? threads : std::max(1u, boost::thread::hardware_concurrency());
+}
+
+void ParallelPgnParser::play(Position& position, const Move& move) {
+    // The move was parsed from SAN, so it is legal.
+    position.make_unvalidated_move_fast(move);
+}
+
+void ParallelPgnParser::work() {
+    while (true) {
+        boost::shared_ptr<Chunk> chunk;
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            while (m_jobs.empty() && !m_stopped) {
+                m_job_condition.wait(lock);
+            }
+            if (m_jobs.empty()) {
+                return;
+            }
+            chunk = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        RecordingVisitor visitor(chunk->events);
+        PgnParser parser(chunk->data.data(), chunk->data.length());
+        parser.parse(visitor);
+
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            chunk->done = true;
+            std::string().swap(chunk->data);
+        }
+        m_done_condition.notify_all();
+    }
+}
+
+void ParallelPgnParser::stop() {
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_stopped = true;
+        m_jobs.clear();
+    }
+    m_job_condition.notify_all();
+}
+
+int ParallelPgnParser::replay(const Chunk& chunk, PgnVisitor& visitor) const {
+    int games = 0;
+
+    for (unsigned int i = 0; i < chunk.events.size(); i++) {
+        const Event& event = chunk.events[i];
+        switch (event.type) {
+            case Event::BEGIN_GAME:
+                visitor.begin_game();
+                break;
+            case Event::HEADER:
+                visitor.header(event.first, event.second);
+                break;
+            case Event::END_HEADERS:
+                visitor.end_headers();
+                break;
+            case Event::SAN:
+                visitor.san(event.first);
+                break;
+            case Event::MOVE:
+                visitor.move(event.first, event.move);
+                break;
+            case Event::NAG:
+                visitor.nag(event.nag);
+                break;
+            case Event::COMMENT:
+                visitor.comment(event.first);
+                break;
+            case Event::BEGIN_VARIATION:
+                visitor.begin_variation();
+                break;
+            case Event::END_VARIATION:
+                visitor.end_variation();
+                break;
+            case Event::RESULT:
+                visitor.result(event.first);
+                break;
+            case Event::END_GAME:
+                visitor.end_game();
+                games++;
+                break;
+            case Event::ERROR:
+                visitor.error(event.first);
+                break;
+        }
+    }
+
+    return games;
+}
+
+int ParallelPgnParser::parse(PgnVisitor& visitor) {
+    m_stopped = false;
+
+    boost::thread_group threads;
+    for (int i = 0; i < m_threads; i++) {
+        threads.create_thread(boost::bind(&ParallelPgnParser::work, this));
+    }
+
+    int games = 0;
+    std::deque<boost::shared_ptr<Chunk> > window;
+
+    try {
+        while (true) {
+            boost::shared_ptr<Chunk> chunk;
+
+            {
+                GilRelease release(m_release_gil);
+
+                // Keep a few chunks per thread in flight.
+                while (window.size() < 4 * (unsigned int) m_threads) {
+                    boost::shared_ptr<Chunk> next(new Chunk());
+                    next->done = false;
+                    if (!m_reader.read_chunk(next->data)) {
+                        break;
+                    }
+
+                    window.push_back(next);
+                    {
+                        boost::mutex::scoped_lock lock(m_mutex);
+                        m_jobs.push_back(next);
+                    }
+                    m_job_condition.notify_one();
+                }
+
+                if (window.empty()) {
+                    break;
+                }
+
+                // Wait for the next chunk in the order of the file.
+                chunk = window.front();
+                window.pop_front();
+                boost::mutex::scoped_lock lock(m_mutex);
+                while (!chunk->done) {
+                    m_done_condition.wait(lock);
+                }
+            }
+
+            games += replay(*chunk, visitor);
+        }
+    } catch (...) {
+        stop();
+        threads.join_all();
+        throw;
+    }
+
+    stop();
+    threads.join_all();
+    return games;
+}
+
+int ParallelPgnParser::python_parse(PgnVisitor& visitor) {
+    m_release_gil = true;
+    int games = parse(visitor);
+    m_release_gil = false;
+    return games;
+}
+
+} // namespace chess
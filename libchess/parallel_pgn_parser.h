@@ -0,0 +1,131 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_PARALLEL_PGN_PARSER_H
+#define LIBCHESS_PARALLEL_PGN_PARSER_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "position.h"
+#include "pgn_parser.h"
+
+namespace chess {
+
+/**
+ * \brief Releases the GIL for the lifetime of the object, if requested.
+ */
+class GilRelease : boost::noncopyable {
+public:
+    GilRelease(bool release);
+    ~GilRelease();
+
+private:
+    PyThreadState *m_state;
+};
+
+/**
+ * \brief Reads a PGN file in chunks of whole games.
+ *
+ * Chunks are cut before an `[Event` tag that follows a blank line. Files
+ * without such tags are cut before any tag pair that follows a blank
+ * line, once a few chunks are pending. Each chunk holds at least
+ * chunk_size bytes, unless it is the last one. Every byte is only
+ * searched for boundaries about once.
+ */
+class PgnChunkReader : boost::noncopyable {
+public:
+    PgnChunkReader(int fd, int chunk_size = CHUNK_SIZE);
+
+    bool read_chunk(std::string& data);
+
+    static const int CHUNK_SIZE = 1024 * 1024;
+
+private:
+    int m_fd;
+    int m_chunk_size;
+    bool m_eof;
+    std::string m_pending;
+    std::string::size_type m_tag_searched;
+};
+
+/**
+ * \brief Parses and validates a PGN file with multiple threads.
+ *
+ * The file is split into chunks at game boundaries by a PgnChunkReader.
+ * The chunks are parsed on a pool
+ * of threads, playing out all moves of the main line and variations. The
+ * recorded tokens are then passed to the visitor in the order of the
+ * file, together with an error() for every move that can not be played.
+ * Moves that could be played are passed to move() with the resolved move,
+ * so the visitor does not have to parse the SAN again.
+ *
+ * Only a few chunks per thread are in flight at any time, so the memory
+ * used does not depend on the size of the file.
+ */
+class ParallelPgnParser : boost::noncopyable {
+public:
+    ParallelPgnParser(int fd, int threads, int chunk_size = PgnChunkReader::CHUNK_SIZE);
+
+    int parse(PgnVisitor& visitor);
+    int python_parse(PgnVisitor& visitor);
+
+private:
+    struct Event {
+        enum Type {
+            BEGIN_GAME, HEADER, END_HEADERS, SAN, MOVE, NAG, COMMENT,
+            BEGIN_VARIATION, END_VARIATION, RESULT, END_GAME, ERROR
+        };
+
+        Type type;
+        int nag;
+        Move move;
+        std::string first;
+        std::string second;
+    };
+
+    struct Chunk {
+        std::string data;
+        std::vector<Event> events;
+        bool done;
+    };
+
+    class RecordingVisitor;
+
+    static void play(Position& position, const Move& move);
+
+    void work();
+    int replay(const Chunk& chunk, PgnVisitor& visitor) const;
+    void stop();
+
+    PgnChunkReader m_reader;
+    int m_threads;
+    bool m_release_gil;
+
+    std::deque<boost::shared_ptr<Chunk> > m_jobs;
+    bool m_stopped;
+    boost::mutex m_mutex;
+    boost::condition_variable m_job_condition;
+    boost::condition_variable m_done_condition;
+};
+
+} // namespace chess
+
+#endif // LIBCHESS_PARALLEL_PGN_PARSER_H
@@ -0,0 +1,197 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "libchess.h"
+#include "perft.h"
+
+namespace chess {
+
+PerftHashTable::PerftHashTable(int megabytes) {
+    // Use the largest power of two number of entries that fits.
+    uint64_t size = 1;
+    while (size * 2 * sizeof(Entry) <= (uint64_t) megabytes * 1024 * 1024) {
+        size *= 2;
+    }
+
+    m_entries.reset(new Entry[size]);
+    m_mask = size - 1;
+
+    for (uint64_t i = 0; i < size; i++) {
+        m_entries[i].check.store(0, boost::memory_order_relaxed);
+        m_entries[i].data.store(0, boost::memory_order_relaxed);
+    }
+}
+
+bool PerftHashTable::probe(uint64_t key, int depth, uint64_t& nodes) const {
+    const Entry& entry = m_entries[key & m_mask];
+    uint64_t data = entry.data.load(boost::memory_order_relaxed);
+    uint64_t check = entry.check.load(boost::memory_order_relaxed);
+
+    if ((check ^ data) != key || (int) (data & 0xff) != depth) {
+        return false;
+    }
+
+    nodes = data >> 8;
+    return true;
+}
+
+void PerftHashTable::store(uint64_t key, int depth, uint64_t nodes) {
+    Entry& entry = m_entries[key & m_mask];
+    uint64_t data = (nodes << 8) | depth;
+    entry.check.store(key ^ data, boost::memory_order_relaxed);
+    entry.data.store(data, boost::memory_order_relaxed);
+}
+
+ParallelPerft::ParallelPerft(const Position& position, int depth, int threads, int hash_megabytes) : m_position(position) {
+    if (depth < 0) {
+        throw new std::invalid_argument("depth");
+    }
+    if (threads < 0) {
+        throw new std::invalid_argument("threads");
+    }
+    if (hash_megabytes < 0) {
+        throw new std::invalid_argument("hash_megabytes");
+    }
+
+    m_depth = depth;
+    m_threads = threads ? threads : std::max(1u, boost::thread::hardware_concurrency());
+    m_hash_table = hash_megabytes ? new PerftHashTable(hash_megabytes) : NULL;
+
+    m_queues.resize(m_threads);
+    m_mutexes.reset(new boost::mutex[m_threads]);
+    m_nodes.resize(m_threads, 0);
+
+    // Deal out one task for every move sequence of the first two plies.
+    if (depth >= 2) {
+        int next = 0;
+        MoveList moves;
+        LegalMoveGenerator::generate(m_position, moves);
+        for (int i = 0; i < moves.size(); i++) {
+            MoveInfo info = m_position.make_unvalidated_move_fast(moves[i]);
+
+            MoveList replies;
+            LegalMoveGenerator::generate(m_position, replies);
+            for (int j = 0; j < replies.size(); j++) {
+                Task task;
+                task.moves[0] = moves[i];
+                task.moves[1] = replies[j];
+                task.length = 2;
+                m_queues[next++ % m_threads].push_back(task);
+            }
+
+            m_position.unmake_move(info);
+        }
+    }
+}
+
+ParallelPerft::~ParallelPerft() {
+    delete m_hash_table;
+}
+
+uint64_t ParallelPerft::run() {
+    if (m_depth < 2) {
+        return m_position.perft(m_depth);
+    }
+
+    boost::thread_group threads;
+    for (int i = 0; i < m_threads; i++) {
+        threads.create_thread(boost::bind(&ParallelPerft::work, this, i));
+    }
+    threads.join_all();
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < m_threads; i++) {
+        nodes += m_nodes[i];
+    }
+    return nodes;
+}
+
+void ParallelPerft::work(int thread) {
+    Task task;
+    while (next_task(thread, task)) {
+        Position position(m_position);
+        for (int i = 0; i < task.length; i++) {
+            position.make_unvalidated_move_fast(task.moves[i]);
+        }
+        m_nodes[thread] += count(position, m_depth - task.length);
+    }
+}
+
+bool ParallelPerft::next_task(int thread, Task& task) {
+    // Take the next task of the own queue.
+    {
+        boost::mutex::scoped_lock lock(m_mutexes[thread]);
+        if (!m_queues[thread].empty()) {
+            task = m_queues[thread].back();
+            m_queues[thread].pop_back();
+            return true;
+        }
+    }
+
+    // Steal from the other end of another queue. No tasks are added after
+    // the start, so once all queues are empty the work is done.
+    for (int i = 1; i < m_threads; i++) {
+        int victim = (thread + i) % m_threads;
+        boost::mutex::scoped_lock lock(m_mutexes[victim]);
+        if (!m_queues[victim].empty()) {
+            task = m_queues[victim].front();
+            m_queues[victim].pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint64_t ParallelPerft::count(Position& position, int depth) {
+    if (depth < 1) {
+        return 1;
+    }
+
+    // The key has to include the en-passant square, so the full hash is
+    // used.
+    uint64_t key = 0;
+    uint64_t nodes = 0;
+    if (m_hash_table && depth >= 2) {
+        key = position.__hash__();
+        if (m_hash_table->probe(key, depth, nodes)) {
+            return nodes;
+        }
+    }
+
+    MoveList moves;
+    int size = LegalMoveGenerator::generate(position, moves);
+    if (depth == 1) {
+        return size;
+    }
+
+    for (int i = 0; i < size; i++) {
+        MoveInfo info = position.make_unvalidated_move_fast(moves[i]);
+        nodes += count(position, depth - 1);
+        position.unmake_move(info);
+    }
+
+    if (m_hash_table) {
+        m_hash_table->store(key, depth, nodes);
+    }
+    return nodes;
+}
+
+} // namespace chess
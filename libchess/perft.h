@@ -0,0 +1,95 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_PERFT_H
+#define LIBCHESS_PERFT_H
+
+#include <deque>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "position.h"
+#include "move.h"
+
+namespace chess {
+
+class Position;
+
+/**
+ * \brief A hash table for perft node counts that can be shared by threads
+ *   without locking.
+ *
+ * Each entry stores the node count and depth together with the key xor-ed
+ * with them. Entries torn by concurrent writes fail the key check and are
+ * treated as misses.
+ */
+class PerftHashTable : boost::noncopyable {
+public:
+    PerftHashTable(int megabytes);
+
+    bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+    void store(uint64_t key, int depth, uint64_t nodes);
+
+private:
+    struct Entry {
+        boost::atomic<uint64_t> check;
+        boost::atomic<uint64_t> data;
+    };
+
+    boost::scoped_array<Entry> m_entries;
+    uint64_t m_mask;
+};
+
+/**
+ * \brief Counts the leaf nodes of the legal move tree with multiple
+ *   threads.
+ *
+ * The tree is split into one task per move sequence of the first two
+ * plies. Tasks are dealt out to the threads, and a thread that runs out of
+ * work steals tasks from the others.
+ */
+class ParallelPerft : boost::noncopyable {
+public:
+    ParallelPerft(const Position& position, int depth, int threads, int hash_megabytes);
+    ~ParallelPerft();
+
+    uint64_t run();
+
+private:
+    struct Task {
+        Move moves[2];
+        int length;
+    };
+
+    void work(int thread);
+    bool next_task(int thread, Task& task);
+    uint64_t count(Position& position, int depth);
+
+    Position m_position;
+    int m_depth;
+    int m_threads;
+    PerftHashTable *m_hash_table;
+
+    std::vector<std::deque<Task> > m_queues;
+    boost::scoped_array<boost::mutex> m_mutexes;
+    std::vector<uint64_t> m_nodes;
+};
+
+} // namespace chess
+
+#endif // LIBCHESS_PERFT_H
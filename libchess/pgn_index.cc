@@ -0,0 +1,369 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pgn_index.h"
+#include "file_io.h"
+
+namespace chess {
+
+namespace {
+
+const char INDEX_MAGIC[8] = { 'P', 'G', 'N', 'I', 'D', 'X', '0', '1' };
+
+// Only this many bytes at the start of the PGN file and before the end of
+// the indexed part are fingerprinted, so that the fingerprint does not
+// change when games are appended.
+const int FINGERPRINT_SIZE = 1024;
+
+void put_uint(char *data, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        data[i] = (char) (value >> (8 * i));
+    }
+}
+
+uint64_t get_uint(const char *data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t) (unsigned char) data[i] << (8 * i);
+    }
+    return value;
+}
+
+int parse_digits(const std::string& value, std::string::size_type start, std::string::size_type length, int max) {
+    if (start + length > value.length()) {
+        return 0;
+    }
+
+    int number = 0;
+    for (std::string::size_type i = start; i < start + length; i++) {
+        if (value[i] < '0' || value[i] > '9') {
+            return 0;
+        }
+        number = number * 10 + value[i] - '0';
+    }
+    return number <= max ? number : 0;
+}
+
+// Collects the key headers of each game.
+class IndexVisitor : public PgnVisitor {
+public:
+    void begin_game() {
+        entry = PgnIndexEntry();
+    }
+
+    void header(const std::string& name, const std::string& value) {
+        entry.set_header(name, value);
+    }
+
+    PgnIndexEntry entry;
+};
+
+} // anonymous namespace
+
+PgnIndexEntry::PgnIndexEntry()
+    : m_offset(0), m_length(0), m_year(0), m_month(0), m_day(0),
+      m_white_elo(0), m_black_elo(0), m_result(0)
+{
+    std::memset(m_eco, 0, sizeof(m_eco));
+}
+
+uint64_t PgnIndexEntry::offset() const {
+    return m_offset;
+}
+
+uint32_t PgnIndexEntry::length() const {
+    return m_length;
+}
+
+int PgnIndexEntry::year() const {
+    return m_year;
+}
+
+int PgnIndexEntry::month() const {
+    return m_month;
+}
+
+int PgnIndexEntry::day() const {
+    return m_day;
+}
+
+std::string PgnIndexEntry::date() const {
+    char date[16];
+    std::snprintf(date, sizeof(date), "%04d.%02d.%02d", m_year, m_month, m_day);
+
+    // Unknown parts are question marks.
+    if (!m_year) {
+        std::memset(date, '?', 4);
+    }
+    if (!m_month) {
+        std::memset(date + 5, '?', 2);
+    }
+    if (!m_day) {
+        std::memset(date + 8, '?', 2);
+    }
+    return date;
+}
+
+std::string PgnIndexEntry::result() const {
+    switch (m_result) {
+        case 1:
+            return "1-0";
+        case 2:
+            return "0-1";
+        case 3:
+            return "1/2-1/2";
+        default:
+            return "*";
+    }
+}
+
+std::string PgnIndexEntry::eco() const {
+    return std::string(m_eco, m_eco[0] ? 3 : 0);
+}
+
+int PgnIndexEntry::white_elo() const {
+    return m_white_elo;
+}
+
+int PgnIndexEntry::black_elo() const {
+    return m_black_elo;
+}
+
+void PgnIndexEntry::set_header(const std::string& name, const std::string& value) {
+    if (name == "Date") {
+        m_year = parse_digits(value, 0, 4, 9999);
+        m_month = parse_digits(value, 5, 2, 12);
+        m_day = parse_digits(value, 8, 2, 31);
+    } else if (name == "Result") {
+        if (value == "1-0") {
+            m_result = 1;
+        } else if (value == "0-1") {
+            m_result = 2;
+        } else if (value == "1/2-1/2") {
+            m_result = 3;
+        } else {
+            m_result = 0;
+        }
+    } else if (name == "ECO") {
+        if (value.length() == 3) {
+            std::memcpy(m_eco, value.data(), 3);
+        }
+    } else if (name == "WhiteElo") {
+        m_white_elo = parse_digits(value, 0, value.length(), 65535);
+    } else if (name == "BlackElo") {
+        m_black_elo = parse_digits(value, 0, value.length(), 65535);
+    }
+}
+
+void PgnIndexEntry::write(char *data) const {
+    put_uint(data, m_offset, 8);
+    put_uint(data + 8, m_length, 4);
+    put_uint(data + 12, m_year, 2);
+    data[14] = m_month;
+    data[15] = m_day;
+    put_uint(data + 16, m_white_elo, 2);
+    put_uint(data + 18, m_black_elo, 2);
+    std::memcpy(data + 20, m_eco, 3);
+    data[23] = m_result;
+}
+
+void PgnIndexEntry::read(const char *data) {
+    m_offset = get_uint(data, 8);
+    m_length = get_uint(data + 8, 4);
+    m_year = get_uint(data + 12, 2);
+    m_month = data[14];
+    m_day = data[15];
+    m_white_elo = get_uint(data + 16, 2);
+    m_black_elo = get_uint(data + 18, 2);
+    std::memcpy(m_eco, data + 20, 3);
+    m_result = data[23];
+}
+
+PgnIndex::PgnIndex(const std::string& path)
+    : m_path(path), m_index_path(path + ".idx"), m_indexed_size(0)
+{
+    m_fd = open(path.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        throw new std::invalid_argument("path");
+    }
+
+    try {
+        update();
+    } catch (...) {
+        close(m_fd);
+        throw;
+    }
+}
+
+PgnIndex::~PgnIndex() {
+    close(m_fd);
+}
+
+uint64_t PgnIndex::fingerprint(uint64_t size) const {
+    char data[2 * FINGERPRINT_SIZE];
+    size_t head = size < FINGERPRINT_SIZE ? size : FINGERPRINT_SIZE;
+    size_t tail = size - head < FINGERPRINT_SIZE ? size - head : FINGERPRINT_SIZE;
+    if (!read_fully_at(m_fd, data, head, 0) ||
+            !read_fully_at(m_fd, data + head, tail, size - tail)) {
+        return 0;
+    }
+
+    // FNV-1a.
+    uint64_t hash = U64(14695981039346656037);
+    for (size_t i = 0; i < head + tail; i++) {
+        hash ^= (unsigned char) data[i];
+        hash *= U64(1099511628211);
+    }
+    return hash;
+}
+
+bool PgnIndex::load(uint64_t pgn_size) {
+    m_entries.clear();
+    m_indexed_size = 0;
+
+    int fd = open(m_index_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    char header[HEADER_SIZE];
+    if (fstat(fd, &st) < 0 || !read_fully_at(fd, header, HEADER_SIZE, 0) ||
+            std::memcmp(header, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    uint64_t indexed_size = get_uint(header + 8, 8);
+    if (indexed_size > pgn_size || get_uint(header + 16, 8) != fingerprint(indexed_size)) {
+        close(fd);
+        return false;
+    }
+
+    // Records after the indexed size are left over from an interrupted
+    // update.
+    std::vector<char> data((st.st_size - HEADER_SIZE) / PgnIndexEntry::SIZE * PgnIndexEntry::SIZE);
+    bool ok = data.empty() || read_fully_at(fd, &data[0], data.size(), HEADER_SIZE);
+    close(fd);
+    if (!ok) {
+        return false;
+    }
+
+    for (size_t i = 0; i < data.size(); i += PgnIndexEntry::SIZE) {
+        PgnIndexEntry entry;
+        entry.read(&data[i]);
+        if (entry.offset() >= indexed_size) {
+            break;
+        }
+        m_entries.push_back(entry);
+    }
+
+    m_indexed_size = indexed_size;
+    return true;
+}
+
+int PgnIndex::update() {
+    struct stat st;
+    if (fstat(m_fd, &st) < 0) {
+        throw new std::invalid_argument("path");
+    }
+
+    bool rebuild = !load(st.st_size);
+    if (!rebuild && m_indexed_size == (uint64_t) st.st_size) {
+        return 0;
+    }
+
+    // Scan the games after the indexed part.
+    if (lseek(m_fd, m_indexed_size, SEEK_SET) < 0) {
+        throw new std::invalid_argument("path");
+    }
+
+    std::vector<char> data;
+    IndexVisitor visitor;
+    PgnParser parser(m_fd);
+    while (parser.parse_headers(visitor)) {
+        visitor.entry.m_offset = parser.game_offset();
+        visitor.entry.m_length = parser.game_length();
+        m_entries.push_back(visitor.entry);
+
+        data.resize(data.size() + PgnIndexEntry::SIZE);
+        visitor.entry.write(&data[data.size() - PgnIndexEntry::SIZE]);
+    }
+    int added = data.size() / PgnIndexEntry::SIZE;
+    m_indexed_size = parser.tell();
+
+    // Append the new records first and only then commit them by updating
+    // the header.
+    int fd = open(m_index_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw new std::invalid_argument("index path");
+    }
+
+    uint64_t end = HEADER_SIZE + (uint64_t) (m_entries.size() - added) * PgnIndexEntry::SIZE;
+    char header[HEADER_SIZE];
+    std::memcpy(header, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    put_uint(header + 16, fingerprint(m_indexed_size), 8);
+
+    bool ok = ftruncate(fd, end) == 0;
+    if (ok && rebuild) {
+        // Nothing is indexed until the records are written.
+        put_uint(header + 8, 0, 8);
+        ok = write_fully_at(fd, header, HEADER_SIZE, 0);
+    }
+    ok = ok && (data.empty() || write_fully_at(fd, &data[0], data.size(), end));
+    put_uint(header + 8, m_indexed_size, 8);
+    ok = ok && write_fully_at(fd, header, HEADER_SIZE, 0);
+    close(fd);
+
+    if (!ok) {
+        throw new std::invalid_argument("index path");
+    }
+
+    return added;
+}
+
+int PgnIndex::__len__() const {
+    return m_entries.size();
+}
+
+const PgnIndexEntry& PgnIndex::__getitem__(int index) const {
+    if (index < 0 || index >= (int) m_entries.size()) {
+        throw std::out_of_range("index");
+    }
+    return m_entries[index];
+}
+
+bool PgnIndex::parse_game(int index, PgnVisitor& visitor) const {
+    const PgnIndexEntry& entry = __getitem__(index);
+
+    std::string data(entry.length(), '\0');
+    if (!data.empty() && !read_fully_at(m_fd, &data[0], data.length(), entry.offset())) {
+        throw new std::invalid_argument("path");
+    }
+
+    PgnParser parser(data);
+    return parser.parse_game(visitor);
+}
+
+} // namespace chess
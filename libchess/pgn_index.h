@@ -0,0 +1,110 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_PGN_INDEX_H
+#define LIBCHESS_PGN_INDEX_H
+
+#include <string>
+#include <vector>
+
+#include "uint.h"
+#include "pgn_parser.h"
+
+namespace chess {
+
+/**
+ * \brief The location and the key headers of a game in a PGN file.
+ *
+ * Unknown date parts and ratings are 0.
+ */
+class PgnIndexEntry {
+public:
+    PgnIndexEntry();
+
+    uint64_t offset() const;
+    uint32_t length() const;
+
+    int year() const;
+    int month() const;
+    int day() const;
+    std::string date() const;
+
+    std::string result() const;
+    std::string eco() const;
+    int white_elo() const;
+    int black_elo() const;
+
+    void set_header(const std::string& name, const std::string& value);
+
+    static const int SIZE = 24;
+
+private:
+    friend class PgnIndex;
+
+    void write(char *data) const;
+    void read(const char *data);
+
+    uint64_t m_offset;
+    uint32_t m_length;
+    uint16_t m_year;
+    unsigned char m_month;
+    unsigned char m_day;
+    uint16_t m_white_elo;
+    uint16_t m_black_elo;
+    char m_eco[3];
+    unsigned char m_result;
+};
+
+/**
+ * \brief A sidecar index of the games in a PGN file.
+ *
+ * The index is kept next to the PGN file, with `.idx` appended to the
+ * name. It is built in a single scan when missing and brought up to date
+ * incrementally when games have been appended to the PGN file. If the PGN
+ * file has been rewritten, the index is rebuilt.
+ *
+ * The index file starts with a magic number, the number of PGN bytes
+ * indexed and a fingerprint of the first and the last kilobyte of the
+ * indexed part of the PGN file. Then follows
+ * one little endian record of PgnIndexEntry::SIZE bytes per game.
+ */
+class PgnIndex : boost::noncopyable {
+public:
+    PgnIndex(const std::string& path);
+    ~PgnIndex();
+
+    int update();
+
+    int __len__() const;
+    const PgnIndexEntry& __getitem__(int index) const;
+    bool parse_game(int index, PgnVisitor& visitor) const;
+
+    static const int HEADER_SIZE = 24;
+
+private:
+    uint64_t fingerprint(uint64_t size) const;
+    bool load(uint64_t pgn_size);
+
+    std::string m_path;
+    std::string m_index_path;
+    int m_fd;
+    uint64_t m_indexed_size;
+    std::vector<PgnIndexEntry> m_entries;
+};
+
+} // namespace chess
+
+#endif // LIBCHESS_PGN_INDEX_H
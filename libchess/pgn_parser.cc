@@ -0,0 +1,580 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "pgn_parser.h"
+
+namespace chess {
+
+namespace {
+
+bool is_whitespace(int c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// Characters that end a move, move number or result token.
+bool is_token_end(int c) {
+    return c < 0 || is_whitespace(c) || std::strchr("{};$()!?[", c) != NULL;
+}
+
+// Maps the traditional suffix annotations to their NAGs, or 0 if there
+// is no such annotation.
+int suffix_annotation_nag(const std::string& annotation) {
+    if (annotation == "!") {
+        return 1;
+    } else if (annotation == "?") {
+        return 2;
+    } else if (annotation == "!!") {
+        return 3;
+    } else if (annotation == "??") {
+        return 4;
+    } else if (annotation == "!?") {
+        return 5;
+    } else if (annotation == "?!") {
+        return 6;
+    } else {
+        return 0;
+    }
+}
+
+} // anonymous namespace
+
+boost::python::object latin1_to_python(const std::string& str) {
+    return boost::python::object(boost::python::handle<>(
+        PyUnicode_DecodeLatin1(str.data(), str.length(), NULL)));
+}
+
+std::string python_to_latin1(const boost::python::object& str) {
+    if (PyUnicode_Check(str.ptr())) {
+        boost::python::object bytes(boost::python::handle<>(
+            PyUnicode_AsLatin1String(str.ptr())));
+        return std::string(PyBytes_AsString(bytes.ptr()), PyBytes_Size(bytes.ptr()));
+    }
+    return boost::python::extract<std::string>(str);
+}
+
+PgnVisitor::~PgnVisitor() {
+}
+
+void PgnVisitor::begin_game() {
+}
+
+void PgnVisitor::header(const std::string& /* name */, const std::string& /* value */) {
+}
+
+void PgnVisitor::end_headers() {
+}
+
+void PgnVisitor::san(const std::string& /* san */) {
+}
+
+void PgnVisitor::move(const std::string& san, const Move& /* move */) {
+    this->san(san);
+}
+
+void PgnVisitor::nag(int /* nag */) {
+}
+
+void PgnVisitor::comment(const std::string& /* comment */) {
+}
+
+void PgnVisitor::begin_variation() {
+}
+
+void PgnVisitor::end_variation() {
+}
+
+void PgnVisitor::result(const std::string& /* result */) {
+}
+
+void PgnVisitor::end_game() {
+}
+
+void PgnVisitor::error(const std::string& /* message */) {
+}
+
+void PythonPgnVisitor::begin_game() {
+    if (boost::python::override f = get_override("begin_game")) {
+        f();
+    }
+}
+
+void PythonPgnVisitor::header(const std::string& name, const std::string& value) {
+    if (boost::python::override f = get_override("header")) {
+        f(latin1_to_python(name), latin1_to_python(value));
+    }
+}
+
+void PythonPgnVisitor::end_headers() {
+    if (boost::python::override f = get_override("end_headers")) {
+        f();
+    }
+}
+
+void PythonPgnVisitor::san(const std::string& san) {
+    if (boost::python::override f = get_override("san")) {
+        f(latin1_to_python(san));
+    }
+}
+
+void PythonPgnVisitor::move(const std::string& san, const Move& move) {
+    if (boost::python::override f = get_override("move")) {
+        f(latin1_to_python(san), move);
+    } else {
+        PgnVisitor::move(san, move);
+    }
+}
+
+void PythonPgnVisitor::nag(int nag) {
+    if (boost::python::override f = get_override("nag")) {
+        f(nag);
+    }
+}
+
+void PythonPgnVisitor::comment(const std::string& comment) {
+    if (boost::python::override f = get_override("comment")) {
+        f(latin1_to_python(comment));
+    }
+}
+
+void PythonPgnVisitor::begin_variation() {
+    if (boost::python::override f = get_override("begin_variation")) {
+        f();
+    }
+}
+
+void PythonPgnVisitor::end_variation() {
+    if (boost::python::override f = get_override("end_variation")) {
+        f();
+    }
+}
+
+void PythonPgnVisitor::result(const std::string& result) {
+    if (boost::python::override f = get_override("result")) {
+        f(latin1_to_python(result));
+    }
+}
+
+void PythonPgnVisitor::end_game() {
+    if (boost::python::override f = get_override("end_game")) {
+        f();
+    }
+}
+
+void PythonPgnVisitor::error(const std::string& message) {
+    if (boost::python::override f = get_override("error")) {
+        f(latin1_to_python(message));
+    }
+}
+
+void PythonPgnVisitor::default_begin_game() {
+    PgnVisitor::begin_game();
+}
+
+void PythonPgnVisitor::default_header(const std::string& name, const std::string& value) {
+    PgnVisitor::header(name, value);
+}
+
+void PythonPgnVisitor::default_end_headers() {
+    PgnVisitor::end_headers();
+}
+
+void PythonPgnVisitor::default_san(const std::string& san) {
+    PgnVisitor::san(san);
+}
+
+void PythonPgnVisitor::default_move(const std::string& san, const Move& move) {
+    PgnVisitor::move(san, move);
+}
+
+void PythonPgnVisitor::default_nag(int nag) {
+    PgnVisitor::nag(nag);
+}
+
+void PythonPgnVisitor::default_comment(const std::string& comment) {
+    PgnVisitor::comment(comment);
+}
+
+void PythonPgnVisitor::default_begin_variation() {
+    PgnVisitor::begin_variation();
+}
+
+void PythonPgnVisitor::default_end_variation() {
+    PgnVisitor::end_variation();
+}
+
+void PythonPgnVisitor::default_result(const std::string& result) {
+    PgnVisitor::result(result);
+}
+
+void PythonPgnVisitor::default_end_game() {
+    PgnVisitor::end_game();
+}
+
+void PythonPgnVisitor::default_error(const std::string& message) {
+    PgnVisitor::error(message);
+}
+
+PgnParser::PgnParser(int fd)
+    : m_fd(fd), m_buffer(new char[BUFFER_SIZE]), m_line_start(true),
+      m_game_offset(0), m_game_length(0)
+{
+    m_begin = m_position = m_end = m_buffer.get();
+
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    m_offset = offset > 0 ? offset : 0;
+}
+
+PgnParser::PgnParser(const char *data, int length)
+    : m_fd(-1), m_begin(data), m_position(data), m_end(data + length),
+      m_line_start(true), m_offset(0), m_game_offset(0), m_game_length(0)
+{
+}
+
+PgnParser::PgnParser(const std::string& data)
+    : m_fd(-1), m_data(data), m_line_start(true), m_offset(0),
+      m_game_offset(0), m_game_length(0)
+{
+    m_begin = m_position = m_data.data();
+    m_end = m_position + m_data.length();
+}
+
+bool PgnParser::fill() {
+    if (m_fd < 0) {
+        return false;
+    }
+
+    ssize_t length;
+    do {
+        length = read(m_fd, m_buffer.get(), BUFFER_SIZE);
+    } while (length < 0 && errno == EINTR);
+
+    if (length < 0) {
+        throw new std::invalid_argument("fd");
+    }
+
+    m_offset += m_end - m_begin;
+    m_begin = m_position = m_buffer.get();
+    m_end = m_position + length;
+    return length > 0;
+}
+
+uint64_t PgnParser::tell() const {
+    return m_offset + (m_position - m_begin);
+}
+
+uint64_t PgnParser::game_offset() const {
+    return m_game_offset;
+}
+
+uint64_t PgnParser::game_length() const {
+    return m_game_length;
+}
+
+int PgnParser::peek() {
+    if (m_position == m_end && !fill()) {
+        return -1;
+    }
+    return (unsigned char) *m_position;
+}
+
+int PgnParser::next() {
+    int c = peek();
+    if (c >= 0) {
+        m_position++;
+        m_line_start = c == '\n';
+    }
+    return c;
+}
+
+void PgnParser::read_until(char end) {
+    m_token.clear();
+
+    while (peek() >= 0) {
+        const char *found = static_cast<const char *>(std::memchr(m_position, end, m_end - m_position));
+        if (found) {
+            m_token.append(m_position, found);
+            m_position = found + 1;
+            m_line_start = end == '\n';
+            return;
+        }
+
+        m_token.append(m_position, m_end);
+        m_position = m_end;
+    }
+}
+
+void PgnParser::skip_line() {
+    read_until('\n');
+}
+
+void PgnParser::skip_whitespace() {
+    for (int c = peek(); c >= 0; c = peek()) {
+        if (c == '%' && m_line_start) {
+            // Escaped lines are ignored.
+            skip_line();
+        } else if (is_whitespace(c)) {
+            next();
+        } else {
+            break;
+        }
+    }
+}
+
+void PgnParser::parse_header(PgnVisitor& visitor) {
+    // Skip the opening bracket.
+    next();
+
+    while (peek() == ' ' || peek() == '\t') {
+        next();
+    }
+
+    m_name.clear();
+    for (int c = peek(); c >= 0 && (std::isalnum(c) || c == '_'); c = peek()) {
+        m_name += (char) next();
+    }
+
+    while (peek() == ' ' || peek() == '\t') {
+        next();
+    }
+
+    if (m_name.empty() || peek() != '"') {
+        // Ignore malformed tag pairs.
+        skip_line();
+        return;
+    }
+    next();
+
+    m_token.clear();
+    for (int c = next(); c >= 0 && c != '"' && c != '\n'; c = next()) {
+        if (c == '\\' && (peek() == '\\' || peek() == '"')) {
+            c = next();
+        }
+        m_token += (char) c;
+    }
+    visitor.header(m_name, m_token);
+
+    // Skip the closing bracket and anything after it.
+    while (peek() >= 0 && peek() != '\n') {
+        next();
+    }
+}
+
+void PgnParser::parse_movetext(PgnVisitor& visitor) {
+    int depth = 0;
+
+    for (skip_whitespace(); peek() >= 0; skip_whitespace()) {
+        int c = peek();
+
+        if (c == '[') {
+            // Tag pairs of the next game without a result before them.
+            return;
+        } else if (c == '{') {
+            next();
+            read_until('}');
+            visitor.comment(m_token);
+        } else if (c == ';') {
+            next();
+            read_until('\n');
+            if (!m_token.empty() && m_token[m_token.length() - 1] == '\r') {
+                m_token.erase(m_token.length() - 1);
+            }
+            visitor.comment(m_token);
+        } else if (c == '$') {
+            next();
+            int nag = 0;
+            while (peek() >= '0' && peek() <= '9') {
+                nag = nag * 10 + next() - '0';
+            }
+            visitor.nag(nag);
+        } else if (c == '(') {
+            next();
+            depth++;
+            visitor.begin_variation();
+        } else if (c == ')') {
+            next();
+            if (depth > 0) {
+                depth--;
+                visitor.end_variation();
+            }
+        } else if (c == '!' || c == '?') {
+            m_token.clear();
+            while (peek() == '!' || peek() == '?') {
+                m_token += (char) next();
+            }
+            int nag = suffix_annotation_nag(m_token);
+            if (nag) {
+                visitor.nag(nag);
+            }
+        } else {
+            m_token.clear();
+            while (!is_token_end(peek())) {
+                m_token += (char) next();
+            }
+            if (m_token.empty()) {
+                // Skip a stray closing brace or semicolon.
+                next();
+                continue;
+            }
+
+            if (m_token == "1-0" || m_token == "0-1" || m_token == "1/2-1/2" || m_token == "*") {
+                if (depth == 0) {
+                    visitor.result(m_token);
+                    return;
+                }
+                continue;
+            }
+
+            // Strip move numbers, also when not separated from the move.
+            std::string::size_type start = m_token.find_first_not_of("0123456789");
+            if (start == std::string::npos) {
+                continue;
+            } else if (m_token[start] != '.') {
+                start = 0;
+            }
+            start = m_token.find_first_not_of('.', start);
+            if (start == std::string::npos) {
+                continue;
+            }
+
+            m_token.erase(0, start);
+            visitor.san(m_token);
+        }
+    }
+}
+
+void PgnParser::skip_movetext() {
+    int depth = 0;
+
+    for (skip_whitespace(); peek() >= 0; skip_whitespace()) {
+        int c = peek();
+
+        if (c == '[') {
+            // Tag pairs of the next game, also in an unclosed variation,
+            // just like parse_movetext().
+            return;
+        } else if (c == '{') {
+            next();
+            read_until('}');
+        } else if (c == ';') {
+            next();
+            read_until('\n');
+        } else if (c == '(') {
+            next();
+            depth++;
+        } else if (c == ')') {
+            next();
+            if (depth > 0) {
+                depth--;
+            }
+        } else {
+            // Only look closely enough at the tokens to find the result.
+            char token[8];
+            int length = 0;
+            while (!is_token_end(peek())) {
+                c = next();
+                if (length < 8) {
+                    token[length++] = c;
+                }
+            }
+            if (!length) {
+                next();
+            } else if (depth == 0 && ((length == 1 && token[0] == '*') ||
+                    (length == 3 && (!std::memcmp(token, "1-0", 3) || !std::memcmp(token, "0-1", 3))) ||
+                    (length == 7 && !std::memcmp(token, "1/2-1/2", 7)))) {
+                return;
+            }
+        }
+    }
+}
+
+void PgnParser::skip_byte_order_mark() {
+    // Only the start of the file can have a UTF-8 byte order mark.
+    if (tell() == 0 && peek() >= 0 && m_end - m_position >= 3 && !std::memcmp(m_position, "\xef\xbb\xbf", 3)) {
+        m_position += 3;
+    }
+}
+
+bool PgnParser::read_game(PgnVisitor& visitor, bool skip) {
+    skip_byte_order_mark();
+    skip_whitespace();
+    if (peek() < 0) {
+        return false;
+    }
+
+    m_game_offset = tell();
+    visitor.begin_game();
+
+    while (peek() == '[') {
+        parse_header(visitor);
+        skip_whitespace();
+    }
+    visitor.end_headers();
+
+    if (skip) {
+        skip_movetext();
+    } else {
+        parse_movetext(visitor);
+    }
+    m_game_length = tell() - m_game_offset;
+    visitor.end_game();
+    return true;
+}
+
+bool PgnParser::parse_game(PgnVisitor& visitor) {
+    return read_game(visitor, false);
+}
+
+bool PgnParser::parse_headers(PgnVisitor& visitor) {
+    return read_game(visitor, true);
+}
+
+namespace {
+
+// Collects the headers of a game into a dictionary.
+class HeaderDictVisitor : public PgnVisitor {
+public:
+    void header(const std::string& name, const std::string& value) {
+        headers[latin1_to_python(name)] = latin1_to_python(value);
+    }
+
+    boost::python::dict headers;
+};
+
+} // anonymous namespace
+
+boost::python::object PgnParser::python_read_headers() {
+    HeaderDictVisitor visitor;
+    if (!parse_headers(visitor)) {
+        return boost::python::object();
+    }
+    return visitor.headers;
+}
+
+int PgnParser::parse(PgnVisitor& visitor) {
+    int games = 0;
+    while (parse_game(visitor)) {
+        games++;
+    }
+    return games;
+}
+
+} // namespace chess
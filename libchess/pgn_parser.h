@@ -0,0 +1,159 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_PGN_PARSER_H
+#define LIBCHESS_PGN_PARSER_H
+
+#include <boost/python.hpp>
+#include <boost/scoped_array.hpp>
+#include <string>
+
+#include "uint.h"
+#include "move.h"
+
+namespace chess {
+
+/**
+ * \brief Receives the tokens of PGN games from a PgnParser.
+ *
+ * All callbacks do nothing by default. Strings are only valid for the
+ * duration of the call. error() is only called by parsers that validate
+ * the moves, when a game can not be played out. Such parsers report the
+ * moves they could resolve with move(), which calls san() by default.
+ */
+class PgnVisitor {
+public:
+    virtual ~PgnVisitor();
+
+    virtual void begin_game();
+    virtual void header(const std::string& name, const std::string& value);
+    virtual void end_headers();
+    virtual void san(const std::string& san);
+    virtual void move(const std::string& san, const Move& move);
+    virtual void nag(int nag);
+    virtual void comment(const std::string& comment);
+    virtual void begin_variation();
+    virtual void end_variation();
+    virtual void result(const std::string& result);
+    virtual void end_game();
+    virtual void error(const std::string& message);
+};
+
+/**
+ * \brief Forwards the callbacks of a PgnVisitor to the methods of a Python
+ *   subclass.
+ *
+ * Strings are decoded as Latin-1, the traditional PGN encoding. The
+ * default_ methods are exposed as the do-nothing methods of the Python
+ * base class.
+ */
+class PythonPgnVisitor : public PgnVisitor, public boost::python::wrapper<PgnVisitor> {
+public:
+    void begin_game();
+    void header(const std::string& name, const std::string& value);
+    void end_headers();
+    void san(const std::string& san);
+    void move(const std::string& san, const Move& move);
+    void nag(int nag);
+    void comment(const std::string& comment);
+    void begin_variation();
+    void end_variation();
+    void result(const std::string& result);
+    void end_game();
+    void error(const std::string& message);
+
+    void default_begin_game();
+    void default_header(const std::string& name, const std::string& value);
+    void default_end_headers();
+    void default_san(const std::string& san);
+    void default_move(const std::string& san, const Move& move);
+    void default_nag(int nag);
+    void default_comment(const std::string& comment);
+    void default_begin_variation();
+    void default_end_variation();
+    void default_result(const std::string& result);
+    void default_end_game();
+    void default_error(const std::string& message);
+};
+
+/**
+ * \brief A streaming PGN parser.
+ *
+ * Reads games from a file descriptor through a fixed size buffer or from
+ * a buffer in memory, so that the memory used does not depend on the
+ * number of games. The parser does not interpret moves, it only splits the
+ * games into tokens for a PgnVisitor.
+ *
+ * parse_headers() only reports the tag pairs of a game. It skips the
+ * movetext by balancing comments and variations, without looking at the
+ * moves, which is much faster when only the headers are needed.
+ *
+ * Offsets count from the start of the buffer, or from the position of the
+ * file descriptor when the parser was created. game_offset() and
+ * game_length() locate the text of the last game parsed.
+ */
+class PgnParser : boost::noncopyable {
+public:
+    PgnParser(int fd);
+    PgnParser(const char *data, int length);
+    PgnParser(const std::string& data);
+
+    bool parse_game(PgnVisitor& visitor);
+    int parse(PgnVisitor& visitor);
+    bool parse_headers(PgnVisitor& visitor);
+    boost::python::object python_read_headers();
+
+    uint64_t tell() const;
+    uint64_t game_offset() const;
+    uint64_t game_length() const;
+
+    static const int BUFFER_SIZE = 64 * 1024;
+
+private:
+    int peek();
+    int next();
+    bool fill();
+    void skip_line();
+    void skip_byte_order_mark();
+    void skip_whitespace();
+    void parse_header(PgnVisitor& visitor);
+    void parse_movetext(PgnVisitor& visitor);
+    void skip_movetext();
+    bool read_game(PgnVisitor& visitor, bool skip);
+    void read_until(char end);
+
+    int m_fd;
+    std::string m_data;
+    boost::scoped_array<char> m_buffer;
+    const char *m_begin;
+    const char *m_position;
+    const char *m_end;
+    bool m_line_start;
+
+    uint64_t m_offset;
+    uint64_t m_game_offset;
+    uint64_t m_game_length;
+
+    std::string m_name;
+    std::string m_token;
+};
+
+boost::python::object latin1_to_python(const std::string& str);
+std::string python_to_latin1(const boost::python::object& str);
+
+} // namespace chess
+
+#endif // LIBCHESS_PGN_PARSER_H
@@ -21,53 +21,22 @@
 
 namespace chess {
 
+const char PIECE_SYMBOLS[13] = { 0, 'P', 'p', 'N', 'n', 'B', 'b', 'R', 'r', 'Q', 'q', 'K', 'k' };
+const char PIECE_COLORS[13] = { 0, 'w', 'b', 'w', 'b', 'w', 'b', 'w', 'b', 'w', 'b', 'w', 'b' };
+const char PIECE_TYPES[13] = { 0, 'p', 'p', 'n', 'n', 'b', 'b', 'r', 'r', 'q', 'q', 'k', 'k' };
+
 Piece::Piece() {
-    m_symbol = 0;
+    m_code = 0;
 }
 
 Piece::Piece(char symbol) {
-    switch (tolower(symbol)) {
-        case 'p':
-        case 'n':
-        case 'b':
-        case 'r':
-        case 'q':
-        case 'k':
-            m_symbol = symbol;
-            break;
-        default:
-            throw std::invalid_argument("symbol");
-    }
-}
-
-Piece::Piece(const Piece& piece) {
-    m_symbol = piece.m_symbol;
-}
-
-char Piece::color() const {
-    if (m_symbol == 0) {
-        throw std::logic_error("Called color() of null piece.");
-    } else if (m_symbol == toupper(m_symbol)) {
-        return 'w';
-    } else {
-        return 'b';
-    }
-}
-
-char Piece::type() const {
-    if (m_symbol == 0) {
-        throw std::logic_error("Called type() of null piece.");
-    } else {
-        return tolower(m_symbol);
+    for (m_code = 1; m_code < 13; m_code++) {
+        if (PIECE_SYMBOLS[m_code] == symbol) {
+            return;
+        }
     }
-}
 
-char Piece::symbol() const {
-    if (m_symbol == 0) {
-        throw new std::logic_error("Called symbol() of null piece.");
-    } else {
-        return m_symbol;
-    }
+    throw std::invalid_argument("symbol");
 }
 
 std::string Piece::full_color() const {
@@ -105,23 +74,6 @@ int Piece::__hash__() const {
     return symbol();
 }
 
-bool Piece::is_valid() const {
-    return m_symbol != 0;
-}
-
-Piece& Piece::operator=(const Piece& rhs) {
-    m_symbol = rhs.m_symbol;
-    return *this;
-}
-
-bool Piece::operator==(const Piece& rhs) const {
-    return m_symbol == rhs.m_symbol;
-}
-
-bool Piece::operator!=(const Piece& rhs) const {
-    return m_symbol != rhs.m_symbol;
-}
-
 Piece Piece::from_color_and_type(char color, char type) {
     if (color == 'w') {
         return Piece(toupper(type));
@@ -23,34 +23,76 @@ namespace chess {
 
 /**
  * \brief An immutable chess piece.
+ *
+ * The piece is stored as a small code, 1 + 2 * type index + color index, so
+ * that 0 is the null piece. Properties are looked up in tables indexed by
+ * the code. Only the constructors validate their arguments, so the
+ * accessors must not be called on the null piece.
  */
 class Piece {
 public:
     Piece();
     Piece(char symbol);
-    Piece(const Piece& piece);
 
     char color() const;
     char type() const;
     char symbol() const;
     std::string full_color() const;
     std::string full_type() const;
+    int color_index() const;
+    int type_index() const;
 
     std::string __repr__() const;
     int __hash__() const;
 
     bool is_valid() const;
 
-    Piece& operator=(const Piece& rhs);
     bool operator==(const Piece& rhs) const;
     bool operator!=(const Piece& rhs) const;
 
     static Piece from_color_and_type(char color, char type);
 
 private:
-    char m_symbol;
+    unsigned char m_code;
 };
 
+// Lookup tables indexed by piece code.
+extern const char PIECE_SYMBOLS[13];
+extern const char PIECE_COLORS[13];
+extern const char PIECE_TYPES[13];
+
+inline char Piece::color() const {
+    return PIECE_COLORS[m_code];
+}
+
+inline char Piece::type() const {
+    return PIECE_TYPES[m_code];
+}
+
+inline char Piece::symbol() const {
+    return PIECE_SYMBOLS[m_code];
+}
+
+inline int Piece::color_index() const {
+    return (m_code - 1) & 1;
+}
+
+inline int Piece::type_index() const {
+    return (m_code - 1) >> 1;
+}
+
+inline bool Piece::is_valid() const {
+    return m_code != 0;
+}
+
+inline bool Piece::operator==(const Piece& rhs) const {
+    return m_code == rhs.m_code;
+}
+
+inline bool Piece::operator!=(const Piece& rhs) const {
+    return m_code != rhs.m_code;
+}
+
 std::ostream& operator<<(std::ostream& out, const Piece& piece);
 
 } // namespace chess
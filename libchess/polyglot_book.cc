@@ -0,0 +1,251 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "polyglot_book.h"
+#include "bitboard.h"
+
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
+
+namespace chess {
+
+namespace {
+
+uint64_t get_big_endian(const char *data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value = value << 8 | (unsigned char) data[i];
+    }
+    return value;
+}
+
+void put_big_endian(char *data, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) {
+        data[i] = (char) value;
+        value >>= 8;
+    }
+}
+
+inline void prefetch(const void *address) {
+#ifdef _MSC_VER
+    _mm_prefetch((const char *) address, _MM_HINT_T0);
+#else
+    __builtin_prefetch(address);
+#endif
+}
+
+// The number of keys in a cache line.
+const size_t KEYS_PER_LINE = 64 / sizeof(uint64_t);
+
+} // anonymous namespace
+
+PolyglotBookRange::PolyglotBookRange(const char *begin, const char *end)
+    : m_begin(begin), m_end(end) { }
+
+const char *PolyglotBookRange::begin() const {
+    return m_begin;
+}
+
+const char *PolyglotBookRange::end() const {
+    return m_end;
+}
+
+bool PolyglotBookRange::empty() const {
+    return m_begin == m_end;
+}
+
+int PolyglotBookRange::__len__() const {
+    return (m_end - m_begin) / PolyglotBook::ENTRY_SIZE;
+}
+
+PolyglotOpeningBookEntry PolyglotBookRange::__getitem__(int index) const {
+    if (index < 0 || index >= __len__()) {
+        throw std::out_of_range("index");
+    }
+    return decode(m_begin + (size_t) index * PolyglotBook::ENTRY_SIZE);
+}
+
+uint64_t PolyglotBookRange::key(const char *entry) {
+    return get_big_endian(entry, 8);
+}
+
+PolyglotOpeningBookEntry PolyglotBookRange::decode(const char *entry) {
+    return PolyglotOpeningBookEntry(
+        get_big_endian(entry, 8),
+        get_big_endian(entry + 8, 2),
+        get_big_endian(entry + 10, 2),
+        get_big_endian(entry + 12, 4));
+}
+
+void PolyglotBookRange::encode(const PolyglotOpeningBookEntry& entry, char *data) {
+    put_big_endian(data, entry.key(), 8);
+    put_big_endian(data + 8, entry.raw_move(), 2);
+    put_big_endian(data + 10, entry.weight(), 2);
+    put_big_endian(data + 12, entry.learn(), 4);
+}
+
+PolyglotBook::PolyglotBook(const std::string& path)
+    : m_data(NULL), m_size(0), m_index_keys(NULL), m_index_size(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw new std::invalid_argument("path");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        throw new std::invalid_argument("path");
+    }
+
+    // A trailing partial entry is ignored.
+    m_size = st.st_size / ENTRY_SIZE * ENTRY_SIZE;
+
+    // Empty files can not be mapped.
+    if (m_size) {
+        void *data = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw new std::invalid_argument("path");
+        }
+
+        // Lookups jump around the file.
+        madvise(data, m_size, MADV_RANDOM);
+        m_data = static_cast<const char *>(data);
+    }
+
+    close(fd);
+}
+
+PolyglotBook::~PolyglotBook() {
+    if (m_data) {
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+}
+
+int PolyglotBook::__len__() const {
+    return m_size / ENTRY_SIZE;
+}
+
+PolyglotOpeningBookEntry PolyglotBook::__getitem__(int index) const {
+    return entries().__getitem__(index);
+}
+
+PolyglotBookRange PolyglotBook::entries() const {
+    return PolyglotBookRange(m_data, m_data + m_size);
+}
+
+int PolyglotBook::lower_bound(uint64_t key) const {
+    if (m_index_keys) {
+        // Descend the tree, prefetching the keys three levels below.
+        size_t k = 1;
+        while (k <= m_index_size) {
+            prefetch(m_index_keys + KEYS_PER_LINE * k);
+            k = 2 * k + (m_index_keys[k] < key);
+        }
+
+        // Undo the right turns after the last left turn to get to the
+        // node with the lower bound.
+        k >>= bb_lsb(~k) + 1;
+        return k ? m_index_entries[k] : __len__();
+    }
+
+    size_t low = 0;
+    size_t high = m_size / ENTRY_SIZE;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (PolyglotBookRange::key(m_data + middle * ENTRY_SIZE) < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+PolyglotBookRange PolyglotBook::find_key(uint64_t key) const {
+    // Entries with the same key are adjacent.
+    const char *begin = m_data + (size_t) lower_bound(key) * ENTRY_SIZE;
+    const char *end = begin;
+    while (end != m_data + m_size && PolyglotBookRange::key(end) == key) {
+        end += ENTRY_SIZE;
+    }
+
+    return PolyglotBookRange(begin, end);
+}
+
+PolyglotBookRange PolyglotBook::find(const Position& position) const {
+    return find_key(position.__hash__());
+}
+
+size_t PolyglotBook::build_index(const std::vector<uint64_t>& keys, const std::vector<uint32_t>& entries, size_t i, size_t k) {
+    // An in-order walk of the tree visits the keys in sorted order.
+    if (k <= m_index_size) {
+        i = build_index(keys, entries, i, 2 * k);
+        m_index_keys[k] = keys[i];
+        m_index_entries[k] = entries[i];
+        i = build_index(keys, entries, i + 1, 2 * k + 1);
+    }
+    return i;
+}
+
+void PolyglotBook::load_into_memory() {
+    if (m_index_keys || !m_data) {
+        return;
+    }
+
+    if (m_size / ENTRY_SIZE > 0xffffffff) {
+        throw new std::invalid_argument("book too large");
+    }
+
+    // Read the whole book, collecting the first entry of each key.
+    madvise(const_cast<char *>(m_data), m_size, MADV_WILLNEED);
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> entries;
+    for (size_t i = 0; i < m_size / ENTRY_SIZE; i++) {
+        uint64_t key = PolyglotBookRange::key(m_data + i * ENTRY_SIZE);
+        if (keys.empty() || keys.back() != key) {
+            if (!keys.empty() && keys.back() > key) {
+                throw new std::invalid_argument("book is not sorted");
+            }
+            keys.push_back(key);
+            entries.push_back(i);
+        }
+    }
+
+    m_index_size = keys.size();
+    m_index_storage.resize(m_index_size + 1 + KEYS_PER_LINE);
+    m_index_entries.resize(m_index_size + 1);
+
+    // Align the index to a cache line.
+    size_t address = (size_t) &m_index_storage[0];
+    m_index_keys = &m_index_storage[(64 - address % 64) % 64 / sizeof(uint64_t)];
+
+    build_index(keys, entries, 0, 1);
+}
+
+bool PolyglotBook::is_loaded_into_memory() const {
+    return m_index_keys != NULL;
+}
+
+} // namespace chess
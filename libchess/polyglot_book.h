@@ -0,0 +1,104 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_POLYGLOT_BOOK_H
+#define LIBCHESS_POLYGLOT_BOOK_H
+
+#include <string>
+#include <vector>
+#include <boost/utility.hpp>
+
+#include "uint.h"
+#include "position.h"
+#include "polyglot_opening_book_entry.h"
+
+namespace chess {
+
+/**
+ * \brief A range of raw entries in a memory mapped Polyglot opening book.
+ *
+ * Entries are only decoded when accessed. The range is valid as long as
+ * the book it came from.
+ */
+class PolyglotBookRange {
+public:
+    PolyglotBookRange(const char *begin, const char *end);
+
+    const char *begin() const;
+    const char *end() const;
+    bool empty() const;
+
+    int __len__() const;
+    PolyglotOpeningBookEntry __getitem__(int index) const;
+
+    static uint64_t key(const char *entry);
+    static PolyglotOpeningBookEntry decode(const char *entry);
+    static void encode(const PolyglotOpeningBookEntry& entry, char *data);
+
+private:
+    const char *m_begin;
+    const char *m_end;
+};
+
+/**
+ * \brief A Polyglot opening book mapped into memory.
+ *
+ * Polyglot books are sorted by key and consist of big endian records of
+ * ENTRY_SIZE bytes: the key, the move, the weight and the learn value.
+ * Lookups are binary searches on the mapped file, without copying or
+ * decoding the entries on the way.
+ *
+ * load_into_memory() reads the whole book and builds an index of the
+ * distinct keys in Eytzinger order, that is the implicit binary search
+ * tree in breadth first order. The first levels of the tree share a few
+ * cache lines, and the keys a few levels further down the search path are
+ * prefetched, so that lookups wait for far fewer cache misses.
+ */
+class PolyglotBook : boost::noncopyable {
+public:
+    PolyglotBook(const std::string& path);
+    ~PolyglotBook();
+
+    int __len__() const;
+    PolyglotOpeningBookEntry __getitem__(int index) const;
+
+    PolyglotBookRange entries() const;
+    int lower_bound(uint64_t key) const;
+    PolyglotBookRange find_key(uint64_t key) const;
+    PolyglotBookRange find(const Position& position) const;
+
+    void load_into_memory();
+    bool is_loaded_into_memory() const;
+
+    static const int ENTRY_SIZE = 16;
+
+private:
+    size_t build_index(const std::vector<uint64_t>& keys, const std::vector<uint32_t>& entries, size_t i, size_t k);
+
+    const char *m_data;
+    size_t m_size;
+
+    // The index is 1-based. m_index_keys points into the storage, aligned
+    // so that the children of a node share a cache line.
+    std::vector<uint64_t> m_index_storage;
+    uint64_t *m_index_keys;
+    std::vector<uint32_t> m_index_entries;
+    size_t m_index_size;
+};
+
+} // namespace chess
+
+#endif // LIBCHESS_POLYGLOT_BOOK_H
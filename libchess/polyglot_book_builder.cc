@@ -0,0 +1,543 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "libchess.h"
+#include "polyglot_book_builder.h"
+#include "file_io.h"
+#include "record_merger.h"
+
+namespace chess {
+
+namespace {
+
+uint32_t saturating_add(uint32_t a, uint32_t b) {
+    return a > 0xffffffff - b ? 0xffffffff : a + b;
+}
+
+} // anonymous namespace
+
+bool PolyglotBookBuilder::Record::operator<(const Record& rhs) const {
+    return key < rhs.key || (key == rhs.key && move < rhs.move);
+}
+
+/**
+ * \brief Merges sorted runs, summing the weights of the same moves.
+ */
+class PolyglotBookBuilder::RunMerger {
+public:
+    RunMerger(const std::vector<int>& fds) : m_merger(fds, sizeof(Record), compare_records) {
+        m_more = m_merger.next();
+    }
+
+    bool next(Record& record) {
+        if (!m_more) {
+            return false;
+        }
+
+        std::memcpy(&record, m_merger.record(), sizeof(Record));
+        while ((m_more = m_merger.next())) {
+            Record other;
+            std::memcpy(&other, m_merger.record(), sizeof(Record));
+            if (other.key != record.key || other.move != record.move) {
+                break;
+            }
+            record.weight = saturating_add(record.weight, other.weight);
+        }
+        return true;
+    }
+
+private:
+    RecordMerger m_merger;
+    bool m_more;
+};
+
+/**
+ * \brief Records the weighted moves of the main line of games.
+ */
+class PolyglotBookBuilder::BookVisitor : public PgnVisitor {
+public:
+    BookVisitor(PolyglotBookBuilder& builder, std::vector<Record>& records)
+        : m_builder(builder), m_records(records), m_games(0) { }
+
+    void begin_game() {
+        m_position.reset();
+        m_ply = 0;
+        m_depth = 0;
+        m_valid = true;
+        m_white_weight = 0;
+        m_black_weight = 0;
+    }
+
+    void header(const std::string& name, const std::string& value) {
+        if (name == "FEN") {
+            try {
+                m_position.set_fen(value.c_str(), value.length());
+            } catch (const std::invalid_argument& e) {
+                m_valid = false;
+            } catch (std::invalid_argument *e) {
+                delete e;
+                m_valid = false;
+            }
+        } else if (name == "Result") {
+            if (value == "1-0") {
+                m_white_weight = 2;
+            } else if (value == "0-1") {
+                m_black_weight = 2;
+            } else if (value == "1/2-1/2") {
+                m_white_weight = 1;
+                m_black_weight = 1;
+            }
+        }
+    }
+
+    void end_headers() {
+        if (!m_white_weight && !m_black_weight) {
+            m_valid = false;
+        }
+    }
+
+    void san(const std::string& san) {
+        if (!m_valid || m_depth || m_ply >= m_builder.m_max_ply) {
+            return;
+        }
+
+        Move move;
+        try {
+            move = m_position.get_move_from_san(san.c_str(), san.length());
+        } catch (const std::invalid_argument& e) {
+            m_valid = false;
+            return;
+        } catch (std::invalid_argument *e) {
+            delete e;
+            m_valid = false;
+            return;
+        }
+
+        // Moves leading to a loss have no weight and are not recorded.
+        uint32_t weight = m_position.turn() == 'w' ? m_white_weight : m_black_weight;
+        if (weight) {
+            if (m_records.size() >= m_builder.m_buffer_records) {
+                m_builder.compact(m_records);
+            }
+
+            Record record;
+            record.key = m_position.__hash__();
+            record.weight = weight;
+            record.move = encode_move(m_position, move);
+            m_records.push_back(record);
+        }
+
+        play(m_position, move);
+        m_ply++;
+    }
+
+    void begin_variation() {
+        m_depth++;
+    }
+
+    void end_variation() {
+        m_depth--;
+    }
+
+    void end_game() {
+        m_games++;
+    }
+
+    int games() const {
+        return m_games;
+    }
+
+private:
+    PolyglotBookBuilder& m_builder;
+    std::vector<Record>& m_records;
+    Position m_position;
+    int m_ply;
+    int m_depth;
+    bool m_valid;
+    uint32_t m_white_weight;
+    uint32_t m_black_weight;
+    int m_games;
+};
+
+PolyglotBookBuilder::PolyglotBookBuilder(const std::string& path, int max_ply, int threads, int memory_megabytes, int max_runs)
+    : m_path(path), m_max_ply(max_ply), m_max_runs(max_runs), m_games(0), m_failed(false), m_stopped(false)
+{
+    if (max_ply < 0) {
+        throw new std::invalid_argument("max_ply");
+    }
+
+    if (threads < 0) {
+        throw new std::invalid_argument("threads");
+    }
+
+    if (memory_megabytes <= 0) {
+        throw new std::invalid_argument("memory_megabytes");
+    }
+
+    if (max_runs < 2) {
+        throw new std::invalid_argument("max_runs");
+    }
+
+    m_threads = threads ? threads : std::max(1u, boost::thread::hardware_concurrency());
+
+    // The memory is shared between the buffers of all threads.
+    m_buffer_records = std::max((size_t) 1024,
+        (size_t) memory_megabytes * 1024 * 1024 / sizeof(Record) / m_threads);
+}
+
+PolyglotBookBuilder::~PolyglotBookBuilder() {
+    for (unsigned int i = 0; i < m_runs.size(); i++) {
+        for (unsigned int j = 0; j < m_runs[i].size(); j++) {
+            close(m_runs[i][j]);
+        }
+    }
+}
+
+uint16_t PolyglotBookBuilder::encode_move(const Position& position, const Move& move) {
+    // Polyglot encodes castling moves as the king capturing its own rook.
+    int distance = move.target().file() - move.source().file();
+    if (position.get(move.source()).type() == 'k' && (distance == 2 || distance == -2)) {
+        int file = distance > 0 ? 7 : 0;
+        return Move(move.source(), Square(move.target().rank(), file)).raw();
+    }
+
+    return move.raw();
+}
+
+void PolyglotBookBuilder::play(Position& position, const Move& move) {
+    // The move is known to be legal.
+    position.make_unvalidated_move_fast(move);
+}
+
+bool PolyglotBookBuilder::compare_records(const char *lhs, const char *rhs) {
+    Record a, b;
+    std::memcpy(&a, lhs, sizeof(Record));
+    std::memcpy(&b, rhs, sizeof(Record));
+    return a < b;
+}
+
+int PolyglotBookBuilder::write_position(std::vector<Record>& records, std::vector<PolyglotOpeningBookEntry>& entries, std::vector<char>& buffer) {
+    // Scale the weights to 16 bits.
+    uint64_t max_weight = 0;
+    for (unsigned int i = 0; i < records.size(); i++) {
+        max_weight = std::max<uint64_t>(max_weight, records[i].weight);
+    }
+
+    entries.clear();
+    for (unsigned int i = 0; i < records.size(); i++) {
+        uint64_t weight = records[i].weight;
+        if (max_weight > 0xffff) {
+            weight = weight * 0xffff / max_weight;
+        }
+        if (weight) {
+            entries.push_back(PolyglotOpeningBookEntry(records[i].key, records[i].move, weight, 0));
+        }
+    }
+    records.clear();
+
+    sort_by_weight(entries);
+    append_entries(entries, buffer);
+    return entries.size();
+}
+
+void PolyglotBookBuilder::compact(std::vector<Record>& records) {
+    std::sort(records.begin(), records.end());
+
+    // Sum the weights of the same moves.
+    size_t length = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (length && records[length - 1].key == records[i].key && records[length - 1].move == records[i].move) {
+            records[length - 1].weight = saturating_add(records[length - 1].weight, records[i].weight);
+        } else {
+            records[length++] = records[i];
+        }
+    }
+    records.resize(length);
+
+    // Spill the records if compacting did not free enough space.
+    if (records.size() >= m_buffer_records / 2) {
+        spill(records);
+    }
+}
+
+int PolyglotBookBuilder::create_run() const {
+    std::string name = m_path + ".XXXXXX";
+    int fd = mkstemp(&name[0]);
+    if (fd < 0) {
+        throw new std::invalid_argument("path");
+    }
+
+    // The run is only reachable through the file descriptor.
+    unlink(name.c_str());
+    return fd;
+}
+
+void PolyglotBookBuilder::spill(std::vector<Record>& records) {
+    if (records.empty()) {
+        return;
+    }
+
+    int fd = create_run();
+    if (!write_fully(fd, (const char *) &records[0], records.size() * sizeof(Record)) ||
+            lseek(fd, 0, SEEK_SET) < 0) {
+        close(fd);
+        throw new std::invalid_argument("path");
+    }
+
+    records.clear();
+
+    for (unsigned int level = 0; ; level++) {
+        std::vector<int> runs;
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            if (m_runs.size() <= level) {
+                m_runs.resize(level + 1);
+            }
+            m_runs[level].push_back(fd);
+            if (m_runs[level].size() < m_max_runs) {
+                return;
+            }
+            runs.swap(m_runs[level]);
+        }
+
+        // The level is full. Merge its runs into one run of the next level
+        // on this thread, while the others keep parsing.
+        try {
+            fd = merge_runs(runs);
+        } catch (...) {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_runs[level].insert(m_runs[level].end(), runs.begin(), runs.end());
+            throw;
+        }
+    }
+}
+
+int PolyglotBookBuilder::merge_runs(const std::vector<int>& runs) const {
+    int fd = create_run();
+
+    std::vector<Record> buffer;
+    buffer.reserve(RecordReader::BUFFER_SIZE / sizeof(Record));
+    bool ok = true;
+    try {
+        RunMerger merger(runs);
+        Record record;
+        while (ok && merger.next(record)) {
+            buffer.push_back(record);
+            if (buffer.size() == buffer.capacity()) {
+                ok = write_fully(fd, (const char *) &buffer[0], buffer.size() * sizeof(Record));
+                buffer.clear();
+            }
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+
+    ok = ok && (buffer.empty() || write_fully(fd, (const char *) &buffer[0], buffer.size() * sizeof(Record)));
+    if (!ok || lseek(fd, 0, SEEK_SET) < 0) {
+        close(fd);
+        throw new std::invalid_argument("path");
+    }
+
+    for (unsigned int i = 0; i < runs.size(); i++) {
+        close(runs[i]);
+    }
+    return fd;
+}
+
+void PolyglotBookBuilder::work() {
+    std::vector<Record> records;
+    records.reserve(m_buffer_records);
+    BookVisitor visitor(*this, records);
+
+    try {
+        while (true) {
+            boost::shared_ptr<std::string> chunk;
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+                while (m_jobs.empty() && !m_stopped) {
+                    m_job_condition.wait(lock);
+                }
+                if (m_jobs.empty()) {
+                    break;
+                }
+                chunk = m_jobs.front();
+                m_jobs.pop_front();
+            }
+            m_done_condition.notify_all();
+
+            PgnParser parser(chunk->data(), chunk->length());
+            parser.parse(visitor);
+        }
+
+        compact(records);
+        spill(records);
+    } catch (std::invalid_argument *e) {
+        delete e;
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_failed = true;
+        }
+
+        // Wake up add_pgn() if it is waiting for the queue to drain.
+        m_done_condition.notify_all();
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_games += visitor.games();
+}
+
+void PolyglotBookBuilder::stop() {
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_stopped = true;
+    }
+    m_job_condition.notify_all();
+}
+
+int PolyglotBookBuilder::add_pgn(int fd) {
+    int games = m_games;
+    m_stopped = false;
+    m_failed = false;
+
+    boost::thread_group threads;
+    for (int i = 0; i < m_threads; i++) {
+        threads.create_thread(boost::bind(&PolyglotBookBuilder::work, this));
+    }
+
+    try {
+        PgnChunkReader reader(fd);
+        while (true) {
+            boost::shared_ptr<std::string> chunk(new std::string());
+            if (!reader.read_chunk(*chunk)) {
+                break;
+            }
+
+            // Keep a few chunks per thread in flight.
+            boost::mutex::scoped_lock lock(m_mutex);
+            while (m_jobs.size() >= 2 * (unsigned int) m_threads && !m_failed) {
+                m_done_condition.wait(lock);
+            }
+            if (m_failed) {
+                break;
+            }
+            m_jobs.push_back(chunk);
+            lock.unlock();
+            m_job_condition.notify_one();
+        }
+    } catch (...) {
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_jobs.clear();
+        }
+        stop();
+        threads.join_all();
+        throw;
+    }
+
+    stop();
+    threads.join_all();
+
+    if (m_failed) {
+        m_jobs.clear();
+        throw new std::invalid_argument("path");
+    }
+
+    return m_games - games;
+}
+
+int PolyglotBookBuilder::finish() {
+    // Merge groups of runs, smallest level first, until all of them can
+    // be merged at once.
+    std::vector<int> runs;
+    for (unsigned int i = 0; i < m_runs.size(); i++) {
+        runs.insert(runs.end(), m_runs[i].begin(), m_runs[i].end());
+    }
+    m_runs.assign(1, runs);
+
+    while (m_runs[0].size() > m_max_runs) {
+        runs.assign(m_runs[0].begin(), m_runs[0].begin() + m_max_runs);
+        int fd = merge_runs(runs);
+        m_runs[0].erase(m_runs[0].begin(), m_runs[0].begin() + m_max_runs);
+        m_runs[0].push_back(fd);
+    }
+
+    int fd = open(m_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw new std::invalid_argument("path");
+    }
+
+    std::vector<char> buffer;
+    std::vector<Record> position;
+    std::vector<PolyglotOpeningBookEntry> position_entries;
+    int entries = 0;
+    bool ok = true;
+
+    try {
+        RunMerger merger(m_runs[0]);
+        Record record;
+        while (ok && merger.next(record)) {
+            if (!position.empty() && position.back().key != record.key) {
+                entries += write_position(position, position_entries, buffer);
+                if (buffer.size() >= 64 * 1024) {
+                    ok = write_fully(fd, &buffer[0], buffer.size());
+                    buffer.clear();
+                }
+            }
+            position.push_back(record);
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+
+    entries += write_position(position, position_entries, buffer);
+    ok = ok && (buffer.empty() || write_fully(fd, &buffer[0], buffer.size()));
+    ok = close(fd) == 0 && ok;
+
+    for (unsigned int i = 0; i < m_runs[0].size(); i++) {
+        close(m_runs[0][i]);
+    }
+    m_runs.clear();
+
+    if (!ok) {
+        throw new std::invalid_argument("path");
+    }
+
+    return entries;
+}
+
+int PolyglotBookBuilder::python_add_pgn(int fd) {
+    GilRelease release(true);
+    return add_pgn(fd);
+}
+
+int PolyglotBookBuilder::python_finish() {
+    GilRelease release(true);
+    return finish();
+}
+
+} // namespace chess
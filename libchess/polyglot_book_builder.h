@@ -0,0 +1,112 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_POLYGLOT_BOOK_BUILDER_H
+#define LIBCHESS_POLYGLOT_BOOK_BUILDER_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "uint.h"
+#include "move.h"
+#include "position.h"
+#include "parallel_pgn_parser.h"
+#include "polyglot_opening_book_entry.h"
+
+namespace chess {
+
+/**
+ * \brief Builds a Polyglot opening book from PGN files.
+ *
+ * The moves of the main line are played out up to a maximum ply. Each
+ * move is weighted by the result of the game from the point of view of
+ * the player making it: 2 for a win, 1 for a draw and 0 for a loss.
+ * Games without a decisive or drawn result are skipped.
+ *
+ * The PGN files are parsed in chunks on a pool of threads. Each thread
+ * collects entries in a buffer. Full buffers are sorted, aggregated and
+ * spilled to an unlinked temporary file next to the book. Runs are kept
+ * in levels: once max_runs runs of a level are open, they are merged into
+ * a single run of the next level. So each record is rewritten only once
+ * per level, and the number of file descriptors and the memory for merge
+ * buffers stay small. finish() merges the remaining runs, at most max_runs
+ * at a time, and writes the book, with the entries of each position sorted
+ * by weight. Weights of a position that do not fit into 16 bits are
+ * scaled down, and entries with a weight of 0 are left out.
+ */
+class PolyglotBookBuilder : boost::noncopyable {
+public:
+    PolyglotBookBuilder(const std::string& path, int max_ply, int threads, int memory_megabytes, int max_runs = MAX_RUNS);
+    ~PolyglotBookBuilder();
+
+    int add_pgn(int fd);
+    int finish();
+
+    int python_add_pgn(int fd);
+    int python_finish();
+
+    static const int MAX_RUNS = 64;
+
+private:
+    struct Record {
+        uint64_t key;
+        uint32_t weight;
+        uint16_t move;
+
+        bool operator<(const Record& rhs) const;
+    };
+
+    class RunMerger;
+    class BookVisitor;
+
+    static uint16_t encode_move(const Position& position, const Move& move);
+    static void play(Position& position, const Move& move);
+    static bool compare_records(const char *lhs, const char *rhs);
+    static int write_position(std::vector<Record>& records, std::vector<PolyglotOpeningBookEntry>& entries, std::vector<char>& buffer);
+
+    void work();
+    void compact(std::vector<Record>& records);
+    int create_run() const;
+    void spill(std::vector<Record>& records);
+    int merge_runs(const std::vector<int>& runs) const;
+    void stop();
+
+    std::string m_path;
+    int m_max_ply;
+    int m_threads;
+    size_t m_buffer_records;
+
+    size_t m_max_runs;
+
+    // The file descriptors of the spilled runs by level.
+    std::vector<std::vector<int> > m_runs;
+    int m_games;
+    bool m_failed;
+
+    std::deque<boost::shared_ptr<std::string> > m_jobs;
+    bool m_stopped;
+    boost::mutex m_mutex;
+    boost::condition_variable m_job_condition;
+    boost::condition_variable m_done_condition;
+};
+
+} // namespace chess
+
+#endif // LIBCHESS_POLYGLOT_BOOK_BUILDER_H
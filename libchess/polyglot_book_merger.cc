@@ -0,0 +1,265 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <boost/shared_ptr.hpp>
+
+#include "libchess.h"
+#include "polyglot_book_merger.h"
+#include "file_io.h"
+#include "record_merger.h"
+
+namespace chess {
+
+namespace {
+
+bool compare_keys(const char *lhs, const char *rhs) {
+    return PolyglotBookRange::key(lhs) < PolyglotBookRange::key(rhs);
+}
+
+void close_all(const std::vector<int>& fds) {
+    for (unsigned int i = 0; i < fds.size(); i++) {
+        close(fds[i]);
+    }
+}
+
+} // anonymous namespace
+
+bool PolyglotBookMerger::Child::operator<(const Child& rhs) const {
+    return key < rhs.key;
+}
+
+PolyglotBookMerger::PolyglotBookMerger(const std::string& policy, int min_weight, int max_depth)
+    : m_min_weight(min_weight), m_max_depth(max_depth)
+{
+    if (policy == "sum") {
+        m_policy = SUM;
+    } else if (policy == "max") {
+        m_policy = MAX;
+    } else if (policy == "first") {
+        m_policy = FIRST;
+    } else {
+        throw new std::invalid_argument("policy");
+    }
+}
+
+void PolyglotBookMerger::add_book(const std::string& path) {
+    m_paths.push_back(path);
+}
+
+void PolyglotBookMerger::merge_position(SourceEntries& sources, std::vector<PolyglotOpeningBookEntry>& entries) const {
+    entries.clear();
+
+    // The sources are in the order of the books.
+    for (unsigned int i = 0; i < sources.size(); i++) {
+        const PolyglotOpeningBookEntry& source = sources[i].second;
+
+        if (m_policy == FIRST) {
+            // The entries of the first book are taken as they are.
+            if (sources[i].first != sources[0].first) {
+                break;
+            }
+            entries.push_back(source);
+            continue;
+        }
+
+        unsigned int j = 0;
+        while (j < entries.size() && entries[j].raw_move() != source.raw_move()) {
+            j++;
+        }
+
+        if (j == entries.size()) {
+            entries.push_back(source);
+        } else if (m_policy == MAX) {
+            entries[j].set_weight(std::max(entries[j].weight(), source.weight()));
+        } else {
+            entries[j].set_weight(std::min(0xffff, entries[j].weight() + source.weight()));
+        }
+    }
+
+    unsigned int length = 0;
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        if (entries[i].weight() >= m_min_weight) {
+            entries[length++] = entries[i];
+        }
+    }
+    entries.erase(entries.begin() + length, entries.end());
+
+    sort_by_weight(entries);
+}
+
+void PolyglotBookMerger::find_reachable(std::vector<uint64_t>& keys) const {
+    std::vector<boost::shared_ptr<PolyglotBook> > books;
+    for (unsigned int i = 0; i < m_paths.size(); i++) {
+        books.push_back(boost::shared_ptr<PolyglotBook>(new PolyglotBook(m_paths[i])));
+    }
+
+    // Walk the merged book breadth first, so that each position is
+    // reached with the least number of plies. The keys found so far are
+    // kept sorted. Children are only remembered as a move from their
+    // parent until transpositions have been removed.
+    std::vector<Position> level(1, Position());
+    std::vector<uint64_t> level_keys(1, level[0].__hash__());
+    std::vector<Child> children;
+    std::vector<uint64_t> merged;
+    SourceEntries sources;
+    std::vector<PolyglotOpeningBookEntry> entries;
+
+    for (int depth = 0; depth < m_max_depth && !level.empty(); depth++) {
+        merged.resize(keys.size() + level_keys.size());
+        std::merge(keys.begin(), keys.end(), level_keys.begin(), level_keys.end(), merged.begin());
+        keys.swap(merged);
+
+        if (depth + 1 == m_max_depth) {
+            break;
+        }
+
+        children.clear();
+        for (unsigned int i = 0; i < level.size(); i++) {
+            sources.clear();
+            for (unsigned int j = 0; j < books.size(); j++) {
+                PolyglotBookRange range = books[j]->find_key(level[i].__hash__());
+                for (const char *entry = range.begin(); entry != range.end(); entry += PolyglotBook::ENTRY_SIZE) {
+                    sources.push_back(std::make_pair(j, PolyglotBookRange::decode(entry)));
+                }
+            }
+            merge_position(sources, entries);
+
+            for (unsigned int j = 0; j < entries.size(); j++) {
+                Position position(level[i]);
+                try {
+                    position.make_move_fast(entries[j].move());
+                } catch (const std::invalid_argument& e) {
+                    continue;
+                } catch (std::invalid_argument *e) {
+                    delete e;
+                    continue;
+                }
+
+                Child child;
+                child.key = position.__hash__();
+                if (std::binary_search(keys.begin(), keys.end(), child.key)) {
+                    continue;
+                }
+                child.parent = i;
+                child.move = entries[j].move();
+                children.push_back(child);
+            }
+        }
+
+        // Keep one child per position and play out the moves.
+        std::sort(children.begin(), children.end());
+        std::vector<Position> next_level;
+        level_keys.clear();
+        for (unsigned int i = 0; i < children.size(); i++) {
+            if (i && children[i].key == children[i - 1].key) {
+                continue;
+            }
+            next_level.push_back(level[children[i].parent]);
+            next_level.back().make_move_fast(children[i].move);
+            level_keys.push_back(children[i].key);
+        }
+
+        level.swap(next_level);
+    }
+}
+
+int PolyglotBookMerger::merge(const std::string& path) {
+    std::vector<uint64_t> reachable;
+    if (m_max_depth >= 0) {
+        find_reachable(reachable);
+    }
+
+    std::vector<int> fds;
+    for (unsigned int i = 0; i < m_paths.size(); i++) {
+        int fd = open(m_paths[i].c_str(), O_RDONLY);
+        if (fd < 0) {
+            close_all(fds);
+            throw new std::invalid_argument("path");
+        }
+        fds.push_back(fd);
+    }
+
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        close_all(fds);
+        throw new std::invalid_argument("path");
+    }
+
+    std::vector<char> buffer;
+    std::vector<uint64_t> last_keys(fds.size(), 0);
+    SourceEntries sources;
+    std::vector<PolyglotOpeningBookEntry> entries;
+    int written = 0;
+    bool ok = true;
+
+    try {
+        // Merge the books, smallest key first and the first book first for
+        // equal keys.
+        RecordMerger merger(fds, PolyglotBook::ENTRY_SIZE, compare_keys);
+        bool more = merger.next();
+
+        while (ok && more) {
+            uint64_t key = PolyglotBookRange::key(merger.record());
+
+            // Collect the entries of the position from all books.
+            sources.clear();
+            do {
+                if (PolyglotBookRange::key(merger.record()) < last_keys[merger.source()]) {
+                    throw new std::invalid_argument("book is not sorted");
+                }
+                last_keys[merger.source()] = key;
+                sources.push_back(std::make_pair(merger.source(), PolyglotBookRange::decode(merger.record())));
+            } while ((more = merger.next()) && PolyglotBookRange::key(merger.record()) == key);
+
+            if (m_max_depth >= 0 && !std::binary_search(reachable.begin(), reachable.end(), key)) {
+                continue;
+            }
+
+            merge_position(sources, entries);
+            append_entries(entries, buffer);
+            written += entries.size();
+
+            if (buffer.size() >= RecordReader::BUFFER_SIZE) {
+                ok = write_fully(fd, &buffer[0], buffer.size());
+                buffer.clear();
+            }
+        }
+    } catch (...) {
+        close(fd);
+        close_all(fds);
+        throw;
+    }
+
+    close_all(fds);
+    ok = ok && (buffer.empty() || write_fully(fd, &buffer[0], buffer.size()));
+    ok = close(fd) == 0 && ok;
+    if (!ok) {
+        throw new std::invalid_argument("path");
+    }
+
+    return written;
+}
+
+int PolyglotBookMerger::python_merge(const std::string& path) {
+    GilRelease release(true);
+    return merge(path);
+}
+
+} // namespace chess
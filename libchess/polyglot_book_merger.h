@@ -0,0 +1,87 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_POLYGLOT_BOOK_MERGER_H
+#define LIBCHESS_POLYGLOT_BOOK_MERGER_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/utility.hpp>
+
+#include "uint.h"
+#include "move.h"
+#include "polyglot_opening_book_entry.h"
+
+namespace chess {
+
+/**
+ * \brief Merges and filters sorted Polyglot opening books.
+ *
+ * The books are streamed in a single k-way merge by key. The weights of
+ * the same move in a position are combined according to the policy:
+ *
+ * - `sum` adds the weights, saturating at 65535.
+ * - `max` takes the largest weight.
+ * - `first` copies the entries of a position from the first book that has
+ *   the position unchanged and ignores the other books.
+ *
+ * Entries with a weight below the minimum weight are left out. If a
+ * maximum depth is set, only positions that can be reached from the
+ * starting position in less than that many plies, playing moves that are
+ * kept in the merged book, are written. Finding those positions takes
+ * random access to the books before the merge.
+ *
+ * The entries of each position are written sorted by weight.
+ */
+class PolyglotBookMerger : boost::noncopyable {
+public:
+    PolyglotBookMerger(const std::string& policy, int min_weight, int max_depth);
+
+    void add_book(const std::string& path);
+    int merge(const std::string& path);
+
+    int python_merge(const std::string& path);
+
+private:
+    enum Policy { SUM, MAX, FIRST };
+
+    typedef std::vector<std::pair<int, PolyglotOpeningBookEntry> > SourceEntries;
+
+    /**
+     * \brief A position of the next level of the walk, as a move from a
+     *   position of the current level.
+     */
+    struct Child {
+        uint64_t key;
+        unsigned int parent;
+        Move move;
+
+        bool operator<(const Child& rhs) const;
+    };
+
+    void merge_position(SourceEntries& sources, std::vector<PolyglotOpeningBookEntry>& entries) const;
+    void find_reachable(std::vector<uint64_t>& keys) const;
+
+    Policy m_policy;
+    int m_min_weight;
+    int m_max_depth;
+    std::vector<std::string> m_paths;
+};
+
+} // namespace chess
+
+#endif // LIBCHESS_POLYGLOT_BOOK_MERGER_H
@@ -24,26 +24,8 @@ PolyglotOpeningBookEntry::PolyglotOpeningBookEntry(const Position& key, const Mo
 
     m_key = key.__hash__();
 
-    m_move = (move.target().file() << 0) |
-	     (move.target().rank() << 3) |
-	     (move.source().file() << 6) |
-	     (move.source().rank() << 9);
-
-    switch (move.promotion()) {
-	case 'q':
-	    m_move = m_move | (4 << 12);
-	    break;
-	case 'r':
-	    m_move = m_move | (3 << 12);
-	    break;
-	case 'b':
-	    m_move = m_move | (2 << 12);
-	    break;
-	case 'n':
-	    m_move = m_move | (1 << 12);
-	    break;
-    }
-
+    // Moves are packed the same way as in Polyglot books.
+    m_move = move.raw();
 }
 
 PolyglotOpeningBookEntry::PolyglotOpeningBookEntry(uint64_t key, uint16_t move, uint16_t weight, uint32_t learn) {
@@ -69,42 +51,20 @@ uint16_t PolyglotOpeningBookEntry::raw_move() const {
 }
 
 Move PolyglotOpeningBookEntry::move() const {
-    // Extract source and target square.
-    Square source(
-	(((m_move >> 6) & 0x3f) >> 3) & 0x7,
-	((m_move >> 6) & 0x3f) & 0x7);
-    Square target(
-	((m_move & 0x3f) >> 3) & 0x7,
-	(m_move & 0x3f) & 0x7);
-
-    // Replace non standard castling moves.
-    if (source.name() == "e1") {
-	if (target.name() == "h1") {
-	    return Move::from_uci("e1g1");
-	} else if (target.name() == "a1") {
-	    return Move::from_uci("e1c1");
-	}
-    } else if (source.name() == "e8") {
-	if (target.name() == "h8") {
-	    return Move::from_uci("e8g8");
-	} else if (target.name() == "a8") {
-	    return Move::from_uci("e8c8");
-	}
+    // Replace non standard castling moves. Polyglot encodes them as the
+    // king capturing its own rook.
+    switch (m_move) {
+	case 4 << 6 | 7: // e1h1
+	    return Move::from_raw(4 << 6 | 6);
+	case 4 << 6 | 0: // e1a1
+	    return Move::from_raw(4 << 6 | 2);
+	case 60 << 6 | 63: // e8h8
+	    return Move::from_raw(60 << 6 | 62);
+	case 60 << 6 | 56: // e8a8
+	    return Move::from_raw(60 << 6 | 58);
     }
 
-    // Extract the promotion type.
-    switch ((m_move >> 12) & 0x7) {
-       case 4:
-	   return Move(source, target, 'q');
-       case 3:
-	   return Move(source, target, 'r');
-       case 2:
-	   return Move(source, target, 'b');
-       case 1:
-	   return Move(source, target, 'n');
-       default:
-	   return Move(source, target);
-    }
+    return Move::from_raw(m_move);
 }
 
 uint16_t PolyglotOpeningBookEntry::weight() const {
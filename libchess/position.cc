@@ -15,17 +15,73 @@
 // along with this program. If not, see <http://gnu.org/licenses/>.
 
 #include <stdlib.h>
+#include <cstring>
 #include <vector>
 #include <boost/format.hpp>
-#include <boost/regex.hpp>
-#include <boost/algorithm/string.hpp>
-#include <boost/algorithm/string/split.hpp>
 
 #include "position.h"
 #include "libchess.h"
 
 namespace chess {
 
+namespace {
+
+char *write_int(char *p, int value) {
+    if (value < 0) {
+        *p++ = '-';
+        value = -value;
+    }
+
+    char digits[12];
+    int count = 0;
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    while (count) {
+        *p++ = digits[--count];
+    }
+    return p;
+}
+
+void throw_fen_error(const char *error, const char *fen, const char *p) {
+    throw new std::invalid_argument(boost::str(
+        boost::format("fen: %1% at column %2%") % error % (p - fen + 1)));
+}
+
+const char *skip_fen_whitespace(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+bool is_fen_field_end(const char *p, const char *end) {
+    return p == end || *p == ' ' || *p == '\t';
+}
+
+const char *parse_fen_int(const char *fen, const char *p, const char *end, int min, int& value) {
+    const char *start = p;
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (value > 100000000) {
+            throw_fen_error("move counter out of range", fen, start);
+        }
+        value = value * 10 + (*p++ - '0');
+    }
+
+    if (p == start || !is_fen_field_end(p, end)) {
+        throw_fen_error("invalid move counter", fen, p);
+    }
+    if (value < min) {
+        throw_fen_error("move counter out of range", fen, start);
+    }
+    return p;
+}
+
+} // anonymous namespace
+
 Position::Position() {
     reset();
 }
@@ -35,8 +91,14 @@ Position::Position(const std::string& fen) {
 }
 
 Position::Position(const Position& position) {
-    for (int i = 0; i < 128; i++) {
-        m_board[i] = position.m_board[i];
+    for (int i = 0; i < 64; i++) {
+        m_mailbox[i] = position.m_mailbox[i];
+    }
+    for (int i = 0; i < 2; i++) {
+        m_occupied_co[i] = position.m_occupied_co[i];
+    }
+    for (int i = 0; i < 6; i++) {
+        m_pieces[i] = position.m_pieces[i];
     }
 
     m_turn = position.m_turn;
@@ -47,19 +109,42 @@ Position::Position(const Position& position) {
     m_white_castle_kingside = position.m_white_castle_kingside;
     m_black_castle_queenside = position.m_black_castle_queenside;
     m_black_castle_kingside = position.m_black_castle_kingside;
+    m_hash = position.m_hash;
 }
 
 void Position::clear_board() {
     Piece no_piece;
 
-    for (int i = 0; i < 128; i++) {
-        m_board[i] = no_piece;
+    for (int i = 0; i < 64; i++) {
+        m_mailbox[i] = no_piece;
+    }
+    for (int i = 0; i < 2; i++) {
+        m_occupied_co[i] = BB_VOID;
+    }
+    for (int i = 0; i < 6; i++) {
+        m_pieces[i] = BB_VOID;
+    }
+
+    // Only the castling rights and the turn remain in the hash.
+    m_hash = 0;
+    if (m_white_castle_kingside) {
+        m_hash ^= POLYGLOT_RANDOM_ARRAY[768];
+    }
+    if (m_white_castle_queenside) {
+        m_hash ^= POLYGLOT_RANDOM_ARRAY[768 + 1];
+    }
+    if (m_black_castle_kingside) {
+        m_hash ^= POLYGLOT_RANDOM_ARRAY[768 + 2];
+    }
+    if (m_black_castle_queenside) {
+        m_hash ^= POLYGLOT_RANDOM_ARRAY[768 + 3];
+    }
+    if (m_turn == 'w') {
+        m_hash ^= POLYGLOT_RANDOM_ARRAY[780];
     }
 }
 
 void Position::reset() {
-    clear_board();
-
     // Reset properties.
     m_turn = 'w';
     m_ep_file = 0;
@@ -70,70 +155,152 @@ void Position::reset() {
     m_black_castle_queenside = true;
     m_black_castle_kingside = true;
 
+    clear_board();
+
     // Setup the white pieces.
-    m_board[112] = Piece('R');
-    m_board[113] = Piece('N');
-    m_board[114] = Piece('B');
-    m_board[115] = Piece('Q');
-    m_board[116] = Piece('K');
-    m_board[117] = Piece('B');
-    m_board[118] = Piece('N');
-    m_board[119] = Piece('R');
+    set(Square(0, 0), Piece('R'));
+    set(Square(0, 1), Piece('N'));
+    set(Square(0, 2), Piece('B'));
+    set(Square(0, 3), Piece('Q'));
+    set(Square(0, 4), Piece('K'));
+    set(Square(0, 5), Piece('B'));
+    set(Square(0, 6), Piece('N'));
+    set(Square(0, 7), Piece('R'));
 
     // Setup the white pawns.
-    for (int x88_index = 96; x88_index <= 103; x88_index++) {
-        m_board[x88_index] = Piece('P');
+    for (int file = 0; file < 8; file++) {
+        set(Square(1, file), Piece('P'));
     }
 
     // Setup the black pieces.
-    m_board[0] = Piece('r');
-    m_board[1] = Piece('n');
-    m_board[2] = Piece('b');
-    m_board[3] = Piece('q');
-    m_board[4] = Piece('k');
-    m_board[5] = Piece('b');
-    m_board[6] = Piece('n');
-    m_board[7] = Piece('r');
+    set(Square(7, 0), Piece('r'));
+    set(Square(7, 1), Piece('n'));
+    set(Square(7, 2), Piece('b'));
+    set(Square(7, 3), Piece('q'));
+    set(Square(7, 4), Piece('k'));
+    set(Square(7, 5), Piece('b'));
+    set(Square(7, 6), Piece('n'));
+    set(Square(7, 7), Piece('r'));
 
     // Setup the black pawns.
-    for (int x88_index = 16; x88_index <= 23; x88_index++) {
-        m_board[x88_index] = Piece('p');
+    for (int file = 0; file < 8; file++) {
+        set(Square(6, file), Piece('p'));
     }
 }
 
 Piece Position::get(const Square& square) const {
-    return m_board[square.x88_index()];
+    return m_mailbox[square.index()];
 }
 
 void Position::set(const Square& square, const Piece& piece) {
-    m_board[square.x88_index()] = piece;
+    int index = square.index();
+    Bitboard mask = bb_square(index);
+
+    // Remove the piece that was on the square.
+    Piece previous = m_mailbox[index];
+    if (previous.is_valid()) {
+        m_occupied_co[previous.color_index()] &= ~mask;
+        m_pieces[previous.type_index()] &= ~mask;
+        m_hash ^= piece_hash(previous, index);
+    }
+
+    // Put the new piece.
+    m_mailbox[index] = piece;
+    if (piece.is_valid()) {
+        m_occupied_co[piece.color_index()] |= mask;
+        m_pieces[piece.type_index()] |= mask;
+        m_hash ^= piece_hash(piece, index);
+    }
 }
 
 boost::python::object Position::__getitem__(const boost::python::object& square_key) const {
-    int x88_index = x88_index_from_square_key(square_key);
+    Piece piece = get(square_from_square_key(square_key));
 
-    if (m_board[x88_index].is_valid()) {
-        return boost::python::object(m_board[x88_index]);
+    if (piece.is_valid()) {
+        return boost::python::object(piece);
     } else {
         return boost::python::object();
     }
 }
 
 void Position::__setitem__(const boost::python::object& square_key, const boost::python::object& piece) {
-    int x88_index = x88_index_from_square_key(square_key);
+    Square square = square_from_square_key(square_key);
 
     if (piece.ptr() == Py_None) {
-        m_board[x88_index] = Piece();
+        set(square, Piece());
     } else {
         Piece& p = boost::python::extract<Piece&>(piece);
-        m_board[x88_index] = p;
+        set(square, p);
     }
 }
 
 void Position::__delitem__(const boost::python::object& square_key) {
-    m_board[x88_index_from_square_key(square_key)] = Piece();
+    set(square_from_square_key(square_key), Piece());
+}
+
+Bitboard Position::occupied() const {
+    return m_occupied_co[0] | m_occupied_co[1];
+}
+
+Bitboard Position::occupied_co(char color) const {
+    return m_occupied_co[(color == 'w') ? 0 : 1];
+}
+
+Bitboard Position::pieces(char type, char color) const {
+    return m_pieces[Piece(type).type_index()] & occupied_co(color);
+}
+
+Bitboard Position::attackers_to(char color, int square, Bitboard occupied) const {
+    Bitboard co = occupied_co(color);
+    Bitboard queens = m_pieces[4];
+
+    // Pawns of the given color attack the square if a pawn of the other
+    // color on the square would attack them.
+    return co & ((BB_PAWN_ATTACKS[(color == 'w') ? 1 : 0][square] & m_pieces[0]) |
+                 (BB_KNIGHT_ATTACKS[square] & m_pieces[1]) |
+                 (bb_bishop_attacks(square, occupied) & (m_pieces[2] | queens)) |
+                 (bb_rook_attacks(square, occupied) & (m_pieces[3] | queens)) |
+                 (BB_KING_ATTACKS[square] & m_pieces[5]));
+}
+
+Bitboard Position::attackers_to(char color, const Square& square) const {
+    if (color != 'w' && color != 'b') {
+        throw new std::invalid_argument("color");
+    }
+
+    return attackers_to(color, square.index(), occupied());
+}
+
+bool Position::is_attacked(char color, int square, Bitboard occupied) const {
+    Bitboard co = occupied_co(color);
+
+    // Test the cheap leaper attacks first and the sliders last.
+    if (BB_PAWN_ATTACKS[(color == 'w') ? 1 : 0][square] & m_pieces[0] & co) {
+        return true;
+    }
+    if (BB_KNIGHT_ATTACKS[square] & m_pieces[1] & co) {
+        return true;
+    }
+    if (BB_KING_ATTACKS[square] & m_pieces[5] & co) {
+        return true;
+    }
+
+    Bitboard queens = m_pieces[4];
+    Bitboard rooks = (m_pieces[3] | queens) & co;
+    if (rooks && (bb_rook_attacks(square, occupied) & rooks)) {
+        return true;
+    }
+    Bitboard bishops = (m_pieces[2] | queens) & co;
+    return bishops && (bb_bishop_attacks(square, occupied) & bishops);
 }
 
+bool Position::is_attacked(char color, const Square& square) const {
+    if (color != 'w' && color != 'b') {
+        throw new std::invalid_argument("color");
+    }
+
+    return is_attacked(color, square.index(), occupied());
+}
 
 char Position::turn() const {
     return m_turn;
@@ -141,7 +308,9 @@ char Position::turn() const {
 
 void Position::set_turn(char turn) {
     if (turn == 'w' || turn == 'b') {
-        m_turn = turn;
+        if (turn != m_turn) {
+            toggle_turn();
+        }
     } else {
         throw new std::invalid_argument("turn");
     }
@@ -153,6 +322,8 @@ void Position::toggle_turn() {
     } else {
         m_turn = 'w';
     }
+
+    m_hash ^= POLYGLOT_RANDOM_ARRAY[780];
 }
 
 char Position::ep_file() const {
@@ -238,14 +409,11 @@ Square Position::get_real_ep_square() const {
         return ep_square;
     }
 
-    // A pawn must stand ready to capture.
-    const int offsets[] = { 17, 15 };
-    for (int i = 0; i < 2; i++) {
-        int offset = (m_turn == 'w') ? offsets[i] : - offsets[i];
-        if (m_board[offset].is_valid() && m_board[offset].type() == 'p' &&
-            m_board[offset].color() == m_turn) {
-            return ep_square;
-        }
+    // A pawn must stand ready to capture. These are the pawns that an
+    // opposing pawn on the en-passant square would attack.
+    int them = (m_turn == 'w') ? 1 : 0;
+    if (BB_PAWN_ATTACKS[them][ep_square.index()] & pieces('p', m_turn)) {
+        return ep_square;
     }
 
     return Square();
@@ -285,211 +453,222 @@ void Position::set_ply(int ply) {
 }
 
 std::string Position::fen() const {
+    char buffer[FEN_BUFFER_SIZE];
+    int length = write_fen(buffer, FEN_BUFFER_SIZE);
+    return std::string(buffer, length);
+}
+
+int Position::write_fen(char *buffer, int size) const {
+    if (size < FEN_BUFFER_SIZE) {
+        throw new std::invalid_argument("size");
+    }
+
     // Generate the board part of the FEN.
-    std::string fen;
-    char empty = '0';
-    for (int i = 0; i < 128; i++) {
-        if (!(i & 0x88)) {
-            Square square = Square::from_x88_index(i);
-            Piece piece = get(square);
+    char *p = buffer;
+    for (int rank = 7; rank >= 0; rank--) {
+        char empty = '0';
+        for (int file = 0; file < 8; file++) {
+            Piece piece = m_mailbox[rank * 8 + file];
             if (piece.is_valid()) {
                 if (empty != '0') {
-                    fen += empty;
+                    *p++ = empty;
                     empty = '0';
                 }
-                fen += piece.symbol();
+                *p++ = piece.symbol();
             } else {
                 empty++;
             }
+        }
 
-            if (i != 119 && square.file() == 7) {
-                if (empty != '0') {
-                    fen += empty;
-                    empty = '0';
-                }
-                fen += "/";
-            }
+        if (empty != '0') {
+            *p++ = empty;
+        }
+        if (rank != 0) {
+            *p++ = '/';
         }
-    }
-    if (empty != '0') {
-        fen += empty;
     }
 
     // Add the turn.
-    fen += " ";
-    fen += m_turn;
+    *p++ = ' ';
+    *p++ = m_turn;
 
     // Add castling flags.
-    fen += " ";
-    if (m_white_castle_kingside ||
-        m_white_castle_queenside ||
-        m_black_castle_kingside ||
-        m_black_castle_queenside)
-    {
-        if (m_white_castle_kingside) {
-            fen += 'K';
-        }
-        if (m_white_castle_queenside) {
-            fen += 'Q';
-        }
-        if (m_black_castle_kingside) {
-            fen += 'k';
-        }
-        if (m_black_castle_queenside) {
-            fen += 'q';
-        }
-    } else {
-        fen += '-';
+    *p++ = ' ';
+    if (m_white_castle_kingside) {
+        *p++ = 'K';
+    }
+    if (m_white_castle_queenside) {
+        *p++ = 'Q';
+    }
+    if (m_black_castle_kingside) {
+        *p++ = 'k';
+    }
+    if (m_black_castle_queenside) {
+        *p++ = 'q';
+    }
+    if (p[-1] == ' ') {
+        *p++ = '-';
     }
 
     // Add the en-passant square.
-    fen += " ";
+    *p++ = ' ';
     Square ep_square = get_ep_square();
     if (ep_square.is_valid()) {
-        fen += ep_square.name();
+        *p++ = ep_square.file_name();
+        *p++ = ep_square.rank_name();
     } else {
-        fen += '-';
+        *p++ = '-';
     }
 
-    // Add the half move count.
-    fen += " ";
-    fen += boost::lexical_cast<std::string>(m_half_moves);
-
-    // Add the ply.
-    fen += " ";
-    fen += boost::lexical_cast<std::string>(m_ply);
+    // Add the half move count and the ply.
+    *p++ = ' ';
+    p = write_int(p, m_half_moves);
+    *p++ = ' ';
+    p = write_int(p, m_ply);
 
-    return fen;
+    *p = 0;
+    return p - buffer;
 }
 
 void Position::set_fen(const std::string& fen) {
-    // Ensure there are 6 parts.
-    std::vector<std::string> parts;
-    boost::algorithm::split(parts, fen, boost::is_any_of("\t "), boost::token_compress_on);
-    if (parts.size() != 6) {
-        throw new std::invalid_argument("fen");
-    }
-
-    // Ensure the board part is valid.
-    std::vector<std::string> rows;
-    boost::algorithm::split(rows, parts[0], boost::is_any_of("/"));
-    if (rows.size() != 8) {
-        throw new std::invalid_argument("fen");
-    }
-    for (std::vector<std::string>::iterator row = rows.begin(); row != rows.end(); ++row) {
-        int field_sum = 0;
-        bool previous_was_number = false;
-        for (unsigned int i = 0; i < row->length(); i++) {
-            char c = row->at(i);
-            if (c >= '1' && c <= '8') {
-                if (previous_was_number) {
-                    throw new std::invalid_argument("fen");
-                }
-                field_sum += c - '0';
-                previous_was_number = true;
-            } else {
-                switch (c) {
-                    case 'p':
-                    case 'n':
-                    case 'b':
-                    case 'r':
-                    case 'q':
-                    case 'k':
-                    case 'P':
-                    case 'N':
-                    case 'B':
-                    case 'R':
-                    case 'Q':
-                    case 'K':
-                        field_sum++;
-                        previous_was_number = false;
-                        break;
-                    default:
-                        throw new std::invalid_argument("fen");
-                }
+    set_fen(fen.data(), fen.length());
+}
+
+void Position::set_fen(const char *fen, int length) {
+    const char *end = fen + length;
+    const char *p = skip_fen_whitespace(fen, end);
+
+    // Parse the board part. The position is only changed once the whole
+    // FEN has been validated.
+    Piece board[64];
+    int rank = 7;
+    int file = 0;
+    bool previous_was_number = false;
+    for (; p < end && *p != ' ' && *p != '\t'; p++) {
+        if (*p == '/') {
+            if (file != 8 || rank == 0) {
+                throw_fen_error("wrong number of squares", fen, p);
             }
-        }
-        if (field_sum != 8) {
-            throw new std::invalid_argument("fen");
+            rank--;
+            file = 0;
+            previous_was_number = false;
+        } else if (*p >= '1' && *p <= '8') {
+            if (previous_was_number) {
+                throw_fen_error("consecutive numbers", fen, p);
+            }
+            file += *p - '0';
+            if (file > 8) {
+                throw_fen_error("wrong number of squares", fen, p);
+            }
+            previous_was_number = true;
+        } else {
+            switch (*p) {
+                case 'p': case 'n': case 'b': case 'r': case 'q': case 'k':
+                case 'P': case 'N': case 'B': case 'R': case 'Q': case 'K':
+                    break;
+                default:
+                    throw_fen_error("invalid piece", fen, p);
+            }
+            if (file >= 8) {
+                throw_fen_error("wrong number of squares", fen, p);
+            }
+            board[rank * 8 + file++] = Piece(*p);
+            previous_was_number = false;
         }
     }
-
-    // Check that the turn part is valid.
-    if (parts[1] != "w" && parts[1] != "b") {
-        throw new std::invalid_argument("fen");
+    if (rank != 0 || file != 8) {
+        throw_fen_error("wrong number of squares", fen, p);
     }
 
-    // Check that the castling flag part is valid.
-    if (!boost::regex_match(parts[2], boost::regex("^(KQ?k?q?|Qk?q?|kq?|q|-)$"))) {
-        throw new std::invalid_argument("fen");
+    // Parse the turn part.
+    p = skip_fen_whitespace(p, end);
+    if (p == end || (*p != 'w' && *p != 'b') || !is_fen_field_end(p + 1, end)) {
+        throw_fen_error("invalid turn", fen, p);
     }
+    char turn = *p++;
 
-    // Check that the en-passant part is valid.
-    if (!boost::regex_match(parts[3], boost::regex("^(-|[a-h][36])$"))) {
-        throw new std::invalid_argument("fen");
-    }
-
-    // Check that the half move part is valid.
-    if (!boost::regex_match(parts[4], boost::regex("^0|[1-9][0-9]*$"))) {
-        throw new std::invalid_argument("fen");
+    // Parse the castling part.
+    p = skip_fen_whitespace(p, end);
+    unsigned char castling = 0;
+    if (p < end && *p == '-') {
+        p++;
+    } else {
+        for (; p < end && *p != ' ' && *p != '\t'; p++) {
+            unsigned char flag;
+            switch (*p) {
+                case 'K':
+                    flag = 1;
+                    break;
+                case 'Q':
+                    flag = 2;
+                    break;
+                case 'k':
+                    flag = 4;
+                    break;
+                case 'q':
+                    flag = 8;
+                    break;
+                default:
+                    throw_fen_error("invalid castling rights", fen, p);
+            }
+            if (castling & flag) {
+                throw_fen_error("invalid castling rights", fen, p);
+            }
+            castling |= flag;
+        }
     }
-
-    // Check that the ply part is valid.
-    if (!boost::regex_match(parts[5], boost::regex("^[1-9][0-9]*$"))) {
-        throw new std::invalid_argument("fen");
+    if (!is_fen_field_end(p, end) || (!castling && p[-1] != '-')) {
+        throw_fen_error("invalid castling rights", fen, p);
     }
 
-    // Set the pieces on the board.
-    clear_board();
-    int x88_index = 0;
-    for (unsigned int i = 0; i < parts[0].length(); i++) {
-        char c = parts[0].at(i);
-        if (c == '/') {
-            x88_index += 8;
-        } else if (c >= '1' && c <= '8') {
-            x88_index += c - '0';
-        } else {
-            m_board[x88_index] = Piece(c);
-            x88_index++;
+    // Parse the en-passant part.
+    p = skip_fen_whitespace(p, end);
+    char ep_file = 0;
+    if (p < end && *p == '-') {
+        p++;
+    } else if (end - p >= 2 && p[0] >= 'a' && p[0] <= 'h' && (p[1] == '3' || p[1] == '6')) {
+        ep_file = p[0];
+        p += 2;
+    } else {
+        throw_fen_error("invalid en-passant square", fen, p);
+    }
+    if (!is_fen_field_end(p, end)) {
+        throw_fen_error("invalid en-passant square", fen, p);
+    }
+
+    // Parse the move counters. They are missing in EPDs, which may have
+    // operations instead.
+    int half_moves = 0;
+    int ply = 1;
+    p = skip_fen_whitespace(p, end);
+    if (p < end && *p >= '0' && *p <= '9') {
+        p = parse_fen_int(fen, p, end, 0, half_moves);
+        p = skip_fen_whitespace(p, end);
+        p = parse_fen_int(fen, p, end, 1, ply);
+        p = skip_fen_whitespace(p, end);
+        if (p != end) {
+            throw_fen_error("unexpected trailing characters", fen, p);
         }
     }
 
-    // Set the turn.
-    m_turn = parts[1].at(0);
-
-    // Set the castling rights.
-    m_white_castle_kingside = false;
-    m_white_castle_queenside = false,
-    m_black_castle_kingside = false;
-    m_black_castle_queenside = false;
-    for (unsigned int i = 0; i < parts[2].length(); i++) {
-        switch (parts[2].at(i)) {
-            case 'K':
-                m_white_castle_kingside = true;
-                break;
-            case 'Q':
-                m_white_castle_queenside = true;
-                break;
-            case 'k':
-                m_black_castle_kingside = true;
-                break;
-            case 'q':
-                m_black_castle_queenside = true;
-                break;
-        }
-    }
+    // Set up the position.
+    m_turn = turn;
+    m_white_castle_kingside = castling & 1;
+    m_white_castle_queenside = castling & 2;
+    m_black_castle_kingside = castling & 4;
+    m_black_castle_queenside = castling & 8;
+    m_ep_file = ep_file;
+    m_half_moves = half_moves;
+    m_ply = ply;
 
-    // Set the en-passant file.
-    char ep_file = parts[3].at(0);
-    if (ep_file == '-') {
-        m_ep_file = 0;
-    } else {
-        m_ep_file = ep_file;
+    // Set the pieces on the board. Clearing the board also rehashes the
+    // turn and the castling rights set above.
+    clear_board();
+    for (int i = 0; i < 64; i++) {
+        if (board[i].is_valid()) {
+            set(Square(i), board[i]);
+        }
     }
-
-    // Set the move counters.
-    m_half_moves = boost::lexical_cast<int>(parts[4]);
-    m_ply = boost::lexical_cast<int>(parts[5]);
 }
 
 PseudoLegalMoveGenerator *Position::get_pseudo_legal_moves() const {
@@ -505,36 +684,9 @@ AttackerGenerator *Position::get_attackers(char color, Square target) const {
 }
 
 uint64_t Position::__hash__() const {
-    uint64_t hash = 0;
-
-    // Hash in the board setup.
-    for (int i = 0; i < 128; i++) {
-        if (m_board[i].is_valid()) {
-            Square square = Square::from_x88_index(i);
-
-            const char *pieces = "pPnNbBrRqQkK";
-            int piece_index = 0;
-            while (m_board[i].symbol() != pieces[piece_index]) {
-                piece_index++;
-            }
-
-            hash ^= POLYGLOT_RANDOM_ARRAY[64 * piece_index + 8 * square.rank() + square.file()];
-        }
-    }
-
-    // Hash in the castling flags.
-    if (m_white_castle_kingside) {
-        hash ^= POLYGLOT_RANDOM_ARRAY[768];
-    }
-    if (m_white_castle_queenside) {
-        hash ^= POLYGLOT_RANDOM_ARRAY[768 + 1];
-    }
-    if (m_black_castle_kingside) {
-        hash ^= POLYGLOT_RANDOM_ARRAY[768 + 2];
-    }
-    if (m_black_castle_queenside) {
-        hash ^= POLYGLOT_RANDOM_ARRAY[768 + 3];
-    }
+    // The pieces, castling rights and the turn are hashed in
+    // incrementally.
+    uint64_t hash = m_hash;
 
     // Hash in the en-passant file.
     Square ep_square = get_real_ep_square();
@@ -542,24 +694,16 @@ uint64_t Position::__hash__() const {
         hash ^= POLYGLOT_RANDOM_ARRAY[772 + ep_square.file()];
     }
 
-    // Hash in the turn.
-    if (m_turn == 'w') {
-        hash ^= POLYGLOT_RANDOM_ARRAY[780];
-    }
-
     return hash;
 }
 
 Square Position::get_king(char color) const {
-    Piece king = Piece::from_color_and_type(color, 'k');
-
-    for (int i = 0; i < 128; i++) {
-        if (m_board[i] == king) {
-            return Square::from_x88_index(i);
-        }
+    Bitboard king = pieces('k', color);
+    if (king) {
+        return Square(bb_lsb(king));
+    } else {
+        return Square();
     }
-
-    return Square();
 }
 
 boost::python::object Position::python_get_king(char color) const {
@@ -572,9 +716,9 @@ boost::python::object Position::python_get_king(char color) const {
 }
 
 bool Position::is_king_attacked(char color) const {
-    Square square = get_king(color);
-    AttackerGenerator attackers(*this, opposite_color(color), square);
-    return attackers.__nonzero__();
+    // A missing king can not be attacked.
+    Bitboard king = m_pieces[5] & occupied_co(color);
+    return king && is_attacked(opposite_color(color), bb_lsb(king), occupied());
 }
 
 bool Position::is_check() const {
@@ -582,72 +726,32 @@ bool Position::is_check() const {
 }
 
 bool Position::is_checkmate() const {
-    if (!is_check()) {
-        return false;
-    } else {
-        // TODO: Consider more efficient checkmate detection.
-        LegalMoveGenerator legal_moves(*this);
-        return !legal_moves.__nonzero__();
-    }
+    return is_check() && !LegalMoveGenerator::has_legal_moves(*this);
 }
 
 bool Position::is_stalemate() const {
-   if (is_check()) {
-       return false;
-   } else {
-       LegalMoveGenerator legal_moves(*this);
-       return !legal_moves.__nonzero__();
-   }
+    return !is_check() && !LegalMoveGenerator::has_legal_moves(*this);
 }
 
 bool Position::is_insufficient_material() const {
-    int piece_count = 0;
-    int white_bishops = 0;
-    int black_bishops = 0;
-    int light_square_bishops = 0;
-    int dark_square_bishops = 0;
-
-    // Count pieces.
-    for (int i = 0; i < 128; i++) {
-        if (m_board[i].is_valid()) {
-            piece_count++;
-            switch (m_board[i].symbol()) {
-                case 'b':
-                    white_bishops++;
-                    black_bishops--;
-                case 'B':
-                    black_bishops++;
-                    if (Square::from_x88_index(i).is_dark()) {
-                        dark_square_bishops++;
-                    } else {
-                        light_square_bishops++;
-                    }
-                    break;
-                case 'n':
-                case 'N':
-                    break;
-                case 'q':
-                case 'Q':
-                case 'p':
-                case 'P':
-                case 'r':
-                case 'R':
-                    return false;
-            }
-
-        }
+    // Pawns, rooks and queens are always sufficient material.
+    if (m_pieces[0] || m_pieces[3] || m_pieces[4]) {
+        return false;
     }
 
+    int piece_count = bb_popcount(occupied());
+    Bitboard bishops = m_pieces[2];
+
     if (piece_count == 2) {
         // King versus king.
         return true;
     } else if (piece_count == 3) {
         // King and knight or bishop versus king.
         return true;
-    } else if (piece_count == 2 + white_bishops + black_bishops) {
+    } else if (piece_count == 2 + bb_popcount(bishops)) {
         // Each player with only king an any number of bishops where all
         // bishops are on the same color.
-        if ((light_square_bishops && !dark_square_bishops) || (dark_square_bishops && !light_square_bishops)) {
+        if (!(bishops & BB_DARK_SQUARES) || !(bishops & BB_LIGHT_SQUARES)) {
             return true;
         }
     }
@@ -660,8 +764,7 @@ bool Position::is_game_over() const {
         return true;
     }
 
-    LegalMoveGenerator legal_moves(*this);
-    if (!legal_moves.__nonzero__()) {
+    if (!LegalMoveGenerator::has_legal_moves(*this)) {
         return true;
     }
 
@@ -719,9 +822,15 @@ bool Position::has_queenside_castling_right(char color) const {
 
 void Position::set_kingside_castling_right(char color, bool castle) {
     if (color == 'w') {
-        m_white_castle_kingside = castle;
+        if (m_white_castle_kingside != castle) {
+            m_white_castle_kingside = castle;
+            m_hash ^= POLYGLOT_RANDOM_ARRAY[768];
+        }
     } else if (color == 'b') {
-        m_black_castle_kingside = castle;
+        if (m_black_castle_kingside != castle) {
+            m_black_castle_kingside = castle;
+            m_hash ^= POLYGLOT_RANDOM_ARRAY[768 + 2];
+        }
     } else {
         throw std::invalid_argument("color");
     }
@@ -729,95 +838,139 @@ void Position::set_kingside_castling_right(char color, bool castle) {
 
 void Position::set_queenside_castling_right(char color, bool castle) {
     if (color == 'w') {
-        m_white_castle_queenside = castle;
+        if (m_white_castle_queenside != castle) {
+            m_white_castle_queenside = castle;
+            m_hash ^= POLYGLOT_RANDOM_ARRAY[768 + 1];
+        }
     } else if (color == 'b') {
-        m_black_castle_queenside = castle;
+        if (m_black_castle_queenside != castle) {
+            m_black_castle_queenside = castle;
+            m_hash ^= POLYGLOT_RANDOM_ARRAY[768 + 3];
+        }
     } else {
         throw std::invalid_argument("color");
     }
 }
 
 Move Position::get_move_from_san(const std::string& san) const {
-    LegalMoveGenerator legal_moves(*this);
-
-    if (san == "O-O" || san == "O-O-O") {
-        // Castling moves.
-        Square target;
-        int rank = m_turn == 'w' ? 0 : 7;
-        if (san == "O-O") {
-            target = Square(rank, 6);
-        } else {
-            target = Square(rank, 2);
+    return get_move_from_san(san.data(), san.length());
+}
+
+Move Position::get_move_from_san(const char *san, int length) const {
+    // Ignore check and mate markers, annotations like !? and en-passant
+    // markers at the end.
+    for (int previous = -1; previous != length; ) {
+        previous = length;
+        while (length > 0 && (san[length - 1] == '+' || san[length - 1] == '#' ||
+                              san[length - 1] == '!' || san[length - 1] == '?' ||
+                              san[length - 1] == ' ')) {
+            length--;
         }
-        Move move(Square(rank, 4), target);
+        if (length >= 6 && std::strncmp(san + length - 6, "(e.p.)", 6) == 0) {
+            length -= 6;
+        } else if (length >= 4 && std::strncmp(san + length - 4, "e.p.", 4) == 0) {
+            length -= 4;
+        }
+    }
+
+    MoveList legal_moves;
+    LegalMoveGenerator::generate(*this, legal_moves);
 
-        if (legal_moves.__contains__(move)) {
-            return move;
+    // Castling moves, also written with zeros.
+    if (length == 3 || length == 5) {
+        bool castling = true;
+        for (int i = 0; i < length; i++) {
+            if (i % 2 ? san[i] != '-' : (san[i] != 'O' && san[i] != '0')) {
+                castling = false;
+            }
         }
-    } else {
-        boost::smatch matches;
-        if (boost::regex_match(san, matches, boost::regex("^([NBKRQ])?([a-h])?([1-8])?x?([a-h][1-8])(=[nbrqNBRQ])?(\\+|#)?$"), boost::match_extra)) {
-            // Get the piece type.
-            std::string matched_piece(matches[1].first, matches[1].second);
-            Piece piece = Piece::from_color_and_type(
-                m_turn,
-                matched_piece == "" ? 'p' : tolower(matched_piece.at(0)));
-
-            // Get the target square.
-            std::string matched_target(matches[4].first, matches[4].second);
-            Square target = Square(matched_target);
-
-            // Get the source file and rank.
-            std::string matched_file(matches[2].first, matches[2].second);
-            std::string matched_rank(matches[3].first, matches[3].second);
-            int file = matched_file == "" ? -1 : (matched_file.at(0) - 'a');
-            int rank = matched_rank == "" ? -1 : (matched_rank.at(0) - '1');
-
-            // Get the promotion type.
-            std::string matched_promotion(matches[5].first, matches[5].second);
-            char promotion = matched_promotion == "" ? 0 : tolower(matched_promotion.at(0));
-
-            // Find a matching move.
-            legal_moves.__iter__();
-            Square source;
-            while (legal_moves.has_more()) {
-                Move move = legal_moves.next();
-
-                if (move.promotion() != promotion) {
-                    continue;
-                }
 
-                if (get(move.source()) != piece || move.target() != target) {
-                    continue;
-                }
+        if (castling) {
+            int rank = m_turn == 'w' ? 0 : 7;
+            Move move(Square(rank, 4), Square(rank, length == 3 ? 6 : 2));
+            if (legal_moves.contains(move) && get(move.source()).type() == 'k') {
+                return move;
+            }
+            throw std::invalid_argument("san");
+        }
+    }
 
-                if (file != -1 && file != move.source().file()) {
-                    continue;
-                }
+    int pos = 0;
 
-                if (rank != -1 && rank != move.source().rank()) {
-                    continue;
-                }
+    // The piece type. Pawn moves have none.
+    char type = 'p';
+    if (pos < length && (san[pos] == 'N' || san[pos] == 'B' || san[pos] == 'R' ||
+                         san[pos] == 'Q' || san[pos] == 'K')) {
+        type = tolower(san[pos++]);
+    }
 
-                // Found a matching move. Make sure it is not ambigous.
-                if (source.is_valid()) {
-                    throw std::invalid_argument("san");
-                }
-                source = move.source();
-            }
+    // The promotion type, with or without an equal sign.
+    char promotion = 0;
+    if (length - pos >= 3) {
+        char c = san[length - 1];
+        if (c == 'N' || c == 'B' || c == 'R' || c == 'Q' ||
+            (san[length - 2] == '=' && (c == 'n' || c == 'b' || c == 'r' || c == 'q')))
+        {
+            promotion = tolower(c);
+            length -= (san[length - 2] == '=') ? 2 : 1;
+        }
+    }
 
-            // Return the found move.
-            if (source.is_valid()) {
-                if (promotion) {
-                    return Move(source, target, promotion);
-                } else {
-                    return Move(source, target);
-                }
-            }
+    // The target square.
+    if (length - pos < 2) {
+        throw std::invalid_argument("san");
+    }
+    int target_file = san[length - 2] - 'a';
+    int target_rank = san[length - 1] - '1';
+    if (target_file < 0 || target_file >= 8 || target_rank < 0 || target_rank >= 8) {
+        throw std::invalid_argument("san");
+    }
+    length -= 2;
+
+    // The disambiguating source file and rank, and the capture marker.
+    int file = -1;
+    int rank = -1;
+    if (pos < length && san[pos] >= 'a' && san[pos] <= 'h') {
+        file = san[pos++] - 'a';
+    }
+    if (pos < length && san[pos] >= '1' && san[pos] <= '8') {
+        rank = san[pos++] - '1';
+    }
+    if (pos < length && san[pos] == 'x') {
+        pos++;
+    }
+    if (pos != length) {
+        throw std::invalid_argument("san");
+    }
+
+    // Find the matching move. Make sure it is not ambigous.
+    Square target(target_rank, target_file);
+    int found = -1;
+    for (int i = 0; i < legal_moves.size(); i++) {
+        const Move& move = legal_moves[i];
+        if (move.target() != target || move.promotion() != promotion) {
+            continue;
+        }
+
+        Square source = move.source();
+        if ((file != -1 && file != source.file()) || (rank != -1 && rank != source.rank())) {
+            continue;
         }
+
+        if (m_mailbox[source.index()].type() != type) {
+            continue;
+        }
+
+        if (found != -1) {
+            throw std::invalid_argument("san");
+        }
+        found = i;
     }
 
-    throw std::invalid_argument("san");
+    if (found == -1) {
+        throw std::invalid_argument("san");
+    }
+    return legal_moves[found];
 }
 
 MoveInfo Position::make_move_from_san(const std::string& san) {
@@ -832,6 +985,13 @@ MoveInfo Position::make_unvalidated_move_fast(const Move& move) {
     MoveInfo info(move, piece);
     info.set_captured(get(move.target()));
 
+    // Remember the state that can not be restored from the move itself.
+    info.m_has_undo_state = true;
+    info.m_previous_castling_rights = castling_rights();
+    info.m_previous_ep_file = m_ep_file;
+    info.m_previous_half_moves = m_half_moves;
+    info.m_previous_hash = m_hash;
+
     // Move the piece.
     set(move.target(), get(move.source()));
     set(move.source(), Piece());
@@ -845,17 +1005,17 @@ MoveInfo Position::make_unvalidated_move_fast(const Move& move) {
         // En-passant.
         if (move.target().file() != move.source().file() && !info.captured().is_valid()) {
             // Get information about the captured piece.
-            int capture_square_index;
+            Square capture_square;
             if (m_turn == 'b') {
-                capture_square_index = Square(4, move.target().file()).x88_index();
+                capture_square = Square(4, move.target().file());
             } else {
-                capture_square_index = Square(3, move.target().file()).x88_index();
+                capture_square = Square(3, move.target().file());
             }
-            info.set_captured(m_board[capture_square_index]);
+            info.set_captured(get(capture_square));
             info.set_is_enpassant(true);
 
             // Remove the captured piece.
-            m_board[capture_square_index] = Piece();
+            set(capture_square, Piece());
         }
 
         // If two steps forward, set the en-passant file.
@@ -896,107 +1056,377 @@ MoveInfo Position::make_unvalidated_move_fast(const Move& move) {
        m_ply++;
     }
 
-    // Update castling rights.
-    if (m_turn == 'w') {
-        m_black_castle_kingside = m_black_castle_kingside && could_have_kingside_castling_right('b');
-        m_black_castle_queenside = m_black_castle_queenside && could_have_queenside_castling_right('b');
-    } else {
-        m_white_castle_kingside = m_white_castle_kingside && could_have_kingside_castling_right('w');
-        m_white_castle_queenside = m_white_castle_queenside && could_have_queenside_castling_right('w');
-    }
+    // Update castling rights. Both sides can lose them, either by moving
+    // the king or a rook or by having a rook captured.
+    set_kingside_castling_right('w', m_white_castle_kingside && could_have_kingside_castling_right('w'));
+    set_queenside_castling_right('w', m_white_castle_queenside && could_have_queenside_castling_right('w'));
+    set_kingside_castling_right('b', m_black_castle_kingside && could_have_kingside_castling_right('b'));
+    set_queenside_castling_right('b', m_black_castle_queenside && could_have_queenside_castling_right('b'));
 
     return info;
 }
 
+void Position::unmake_move(const MoveInfo& move_info) {
+    // Move infos that were not made by make_move() can not be taken back.
+    if (!move_info.m_has_undo_state) {
+        throw new std::invalid_argument("move_info");
+    }
+
+    Move move = move_info.move();
+    if (!get(move.target()).is_valid() || get(move.target()).color() == m_turn) {
+        throw new std::invalid_argument("move_info");
+    }
+
+    // It was the previous players turn.
+    toggle_turn();
+    if (m_turn == 'b') {
+        m_ply--;
+    }
+
+    // Move the piece back. This also undoes promotions.
+    set(move.source(), move_info.piece());
+    if (move_info.is_enpassant()) {
+        set(move.target(), Piece());
+        set(Square(move.source().rank(), move.target().file()), move_info.captured());
+    } else {
+        set(move.target(), move_info.captured());
+    }
+
+    // Move the rook back.
+    int backrank = (m_turn == 'w') ? 0 : 7;
+    if (move_info.is_kingside_castle()) {
+        set(Square(backrank, 7), get(Square(backrank, 5)));
+        set(Square(backrank, 5), Piece());
+    } else if (move_info.is_queenside_castle()) {
+        set(Square(backrank, 0), get(Square(backrank, 3)));
+        set(Square(backrank, 3), Piece());
+    }
+
+    // Restore the remaining state.
+    m_white_castle_kingside = move_info.m_previous_castling_rights & 1;
+    m_white_castle_queenside = move_info.m_previous_castling_rights & 2;
+    m_black_castle_kingside = move_info.m_previous_castling_rights & 4;
+    m_black_castle_queenside = move_info.m_previous_castling_rights & 8;
+    m_ep_file = move_info.m_previous_ep_file;
+    m_half_moves = move_info.m_previous_half_moves;
+    m_hash = move_info.m_previous_hash;
+}
+
 MoveInfo Position::make_move(const Move& move) {
     // Make sure the move is valid.
-    LegalMoveGenerator legal_moves(*this);
-    if (!legal_moves.__contains__(move)) {
+    MoveList legal_moves;
+    LegalMoveGenerator::generate(*this, legal_moves);
+    if (!legal_moves.contains(move)) {
         throw new std::invalid_argument("move");
     }
 
-    // Do the move.
+    // Keep the board before the move. The check flags and the SAN are
+    // computed from it, when needed.
+    Bitboard occupied_co[2] = { m_occupied_co[0], m_occupied_co[1] };
+    Bitboard pieces[6];
+    for (int i = 0; i < 6; i++) {
+        pieces[i] = m_pieces[i];
+    }
+    char turn = m_turn;
+
     MoveInfo info = make_unvalidated_move_fast(move);
+    info.m_lazy = true;
+    info.m_previous_turn = turn;
+    for (int i = 0; i < 2; i++) {
+        info.m_previous_occupied_co[i] = occupied_co[i];
+    }
+    for (int i = 0; i < 6; i++) {
+        info.m_previous_pieces[i] = pieces[i];
+    }
+    return info;
+}
 
-    // Get extra infos.
-    info.set_is_check(is_check());
-    info.set_is_checkmate(is_checkmate());
+void Position::make_move_fast(const Move& move) {
+    MoveList legal_moves;
+    LegalMoveGenerator::generate(*this, legal_moves);
+    if (!legal_moves.contains(move)) {
+        throw new std::invalid_argument("move");
+    }
+    make_unvalidated_move_fast(move);
+}
 
-    // Generate the SAN.
-    if (info.is_kingside_castle()) {
-        info.set_san("O-O");
-    } else if (info.is_queenside_castle()) {
-        info.set_san("O-O-O");
-    } else {
-        // Add the piece type.
-        if (info.piece().type() != 'p') {
-            info.set_san(info.san() + (char)toupper(info.piece().type()));
+void Position::make_move_from_san_fast(const std::string& san) {
+    // The move is known to be legal.
+    make_unvalidated_move_fast(get_move_from_san(san));
+}
+
+int Position::replay_san(const std::vector<std::string>& sans, std::vector<uint64_t> *hashes) {
+    for (unsigned int i = 0; i < sans.size(); i++) {
+        // Parsing the SAN already ensures the move is legal.
+        Move move;
+        try {
+            move = get_move_from_san(sans[i].c_str(), sans[i].length());
+        } catch (const std::invalid_argument& e) {
+            return i;
+        } catch (std::invalid_argument *e) {
+            delete e;
+            return i;
         }
 
-        // Add a disambiguator.
-        bool is_ambigous = false;
-        bool same_rank = false;
-        bool same_file = false;
-        legal_moves.__iter__();
-        while (legal_moves.has_more()) {
-            Move m = legal_moves.next();
-            if (get(m.source()) == info.piece() && move.source() != m.source() && move.target() == m.target()) {
-                is_ambigous = true;
-
-                if (move.source().rank() == m.source().rank()) {
-                    same_rank = true;
-                }
-                if (move.source().file() == m.source().file()) {
-                    same_file = true;
-                }
-                if (same_rank && same_file) {
-                    break;
+        make_unvalidated_move_fast(move);
+        if (hashes) {
+            hashes->push_back(__hash__());
+        }
+    }
+
+    return -1;
+}
+
+int Position::replay_uci(const std::vector<std::string>& ucis, std::vector<uint64_t> *hashes) {
+    MoveList legal_moves;
+
+    for (unsigned int i = 0; i < ucis.size(); i++) {
+        Move move;
+        try {
+            move = Move::from_uci(ucis[i]);
+        } catch (const std::invalid_argument& e) {
+            return i;
+        } catch (std::invalid_argument *e) {
+            delete e;
+            return i;
+        }
+
+        legal_moves.clear();
+        LegalMoveGenerator::generate(*this, legal_moves);
+        if (!legal_moves.contains(move)) {
+            return i;
+        }
+
+        make_unvalidated_move_fast(move);
+        if (hashes) {
+            hashes->push_back(__hash__());
+        }
+    }
+
+    return -1;
+}
+
+namespace {
+
+// Copies a Python sequence of strings, so that the whole line can be
+// replayed without calling back into the interpreter.
+void extract_strings(const boost::python::object& sequence, std::vector<std::string>& strings) {
+    int length = boost::python::len(sequence);
+    strings.reserve(length);
+    for (int i = 0; i < length; i++) {
+        strings.push_back(boost::python::extract<std::string>(sequence[i]));
+    }
+}
+
+// Packs the result of a replay into a (position, hashes, illegal index)
+// tuple. Unrequested hashes and the index of a fully legal line are None.
+boost::python::tuple replay_result(const Position& position, const std::vector<uint64_t> *hashes, int illegal) {
+    boost::python::object python_hashes;
+    if (hashes) {
+        boost::python::list list;
+        for (unsigned int i = 0; i < hashes->size(); i++) {
+            list.append((*hashes)[i]);
+        }
+        python_hashes = list;
+    }
+
+    boost::python::object python_illegal;
+    if (illegal >= 0) {
+        python_illegal = boost::python::object(illegal);
+    }
+
+    return boost::python::make_tuple(position, python_hashes, python_illegal);
+}
+
+} // anonymous namespace
+
+boost::python::tuple Position::python_replay_san(const boost::python::object& sans, bool hashes) const {
+    std::vector<std::string> strings;
+    extract_strings(sans, strings);
+
+    Position position(*this);
+    std::vector<uint64_t> ply_hashes;
+    int illegal = position.replay_san(strings, hashes ? &ply_hashes : NULL);
+    return replay_result(position, hashes ? &ply_hashes : NULL, illegal);
+}
+
+boost::python::tuple Position::python_replay_uci(const boost::python::object& ucis, bool hashes) const {
+    std::vector<std::string> strings;
+    extract_strings(ucis, strings);
+
+    Position position(*this);
+    std::vector<uint64_t> ply_hashes;
+    int illegal = position.replay_uci(strings, hashes ? &ply_hashes : NULL);
+    return replay_result(position, hashes ? &ply_hashes : NULL, illegal);
+}
+
+std::string Position::san(const Move& move) const {
+    MoveList legal_moves;
+    LegalMoveGenerator::generate(*this, legal_moves);
+    if (!legal_moves.contains(move)) {
+        throw new std::invalid_argument("move");
+    }
+
+    Position position(*this);
+    position.make_unvalidated_move_fast(move);
+    bool is_check = position.is_check();
+    return san(move, is_check, is_check && position.is_checkmate());
+}
+
+std::string Position::san(const Move& move, bool is_check, bool is_checkmate) const {
+    char buffer[32];
+    char *p = buffer;
+
+    Piece piece = get(move.source());
+    Square source = move.source();
+    Square target = move.target();
+
+    if (piece.type() == 'k' && source.file() == 4 && target.file() == 6) {
+        p = std::strcpy(p, "O-O") + 3;
+    } else if (piece.type() == 'k' && source.file() == 4 && target.file() == 2) {
+        p = std::strcpy(p, "O-O-O") + 5;
+    } else {
+        bool is_capture = get(target).is_valid() ||
+                          (piece.type() == 'p' && source.file() != target.file());
+
+        if (piece.type() == 'p') {
+            // Pawn captures are identified by the source file.
+            if (is_capture) {
+                *p++ = source.file_name();
+            }
+        } else {
+            // Add the piece type.
+            *p++ = toupper(piece.type());
+
+            // Add a disambiguator.
+            MoveList legal_moves;
+            LegalMoveGenerator::generate(*this, legal_moves);
+            bool is_ambigous = false;
+            bool same_rank = false;
+            bool same_file = false;
+            for (int i = 0; i < legal_moves.size(); i++) {
+                const Move& m = legal_moves[i];
+                if (m.target() == target && m.source() != source && get(m.source()) == piece) {
+                    is_ambigous = true;
+                    if (m.source().rank() == source.rank()) {
+                        same_rank = true;
+                    }
+                    if (m.source().file() == source.file()) {
+                        same_file = true;
+                    }
                 }
             }
-        }
-        if (same_rank && same_file) {
-            info.set_san(info.san() + move.source().name());
-        } else if (same_file) {
-            info.set_san(info.san() + (char)('1' + move.source().rank()));
-        } else if (same_rank || is_ambigous) {
-            info.set_san(info.san() + move.source().file_name());
+            if (same_rank && same_file) {
+                *p++ = source.file_name();
+                *p++ = source.rank_name();
+            } else if (same_file) {
+                *p++ = source.rank_name();
+            } else if (same_rank || is_ambigous) {
+                *p++ = source.file_name();
+            }
         }
 
         // Handle captures.
-        if (info.captured().is_valid()) {
-            if (info.piece().type() == 'p') {
-                info.set_san(info.san() + move.source().file_name());
-            }
-            info.set_san(info.san() + "x");
+        if (is_capture) {
+            *p++ = 'x';
         }
 
-        // Add the target name.
-        info.set_san(info.san() + move.target().name());
+        // Add the target name and the promotion.
+        *p++ = target.file_name();
+        *p++ = target.rank_name();
+        if (move.is_promotion()) {
+            *p++ = '=';
+            *p++ = toupper(move.promotion());
+        }
     }
-    if (info.is_checkmate()) {
-        info.set_san(info.san() + "#");
-    } else if (info.is_check()) {
-        info.set_san(info.san() + "+");
+
+    if (is_checkmate) {
+        *p++ = '#';
+    } else if (is_check) {
+        *p++ = '+';
     }
 
-    if (info.is_enpassant()) {
-        info.set_san(info.san() + " (e.p.)");
+    if (piece.type() == 'p' && source.file() != target.file() && !get(target).is_valid()) {
+        p = std::strcpy(p, " (e.p.)") + 7;
     }
 
-    return info;
+    return std::string(buffer, p - buffer);
 }
 
-void Position::make_move_fast(const Move& move) {
-    LegalMoveGenerator legal_moves(*this);
-    if (!legal_moves.__contains__(move)) {
-        throw new std::invalid_argument("move");
+uint64_t Position::perft(int depth) const {
+    Position position(*this);
+    return position.perft_nodes(depth);
+}
+
+uint64_t Position::parallel_perft(int depth, int threads, int hash_megabytes) const {
+    ParallelPerft perft(*this, depth, threads, hash_megabytes);
+    return perft.run();
+}
+
+uint64_t Position::python_parallel_perft(int depth, int threads, int hash_megabytes) const {
+    GilRelease release(true);
+    return parallel_perft(depth, threads, hash_megabytes);
+}
+
+void Position::divide(int depth, std::vector<std::pair<Move, uint64_t> >& results) const {
+    if (depth < 1) {
+        throw new std::invalid_argument("depth");
     }
-    make_unvalidated_move_fast(move);
+
+    Position position(*this);
+    MoveList moves;
+    LegalMoveGenerator::generate(position, moves);
+
+    results.clear();
+    for (int i = 0; i < moves.size(); i++) {
+        MoveInfo info = position.make_unvalidated_move_fast(moves[i]);
+        results.push_back(std::make_pair(moves[i], position.perft_nodes(depth - 1)));
+        position.unmake_move(info);
+    }
+}
+
+boost::python::dict Position::python_divide(int depth) const {
+    std::vector<std::pair<Move, uint64_t> > results;
+    divide(depth, results);
+
+    boost::python::dict dict;
+    for (unsigned int i = 0; i < results.size(); i++) {
+        dict[results[i].first] = results[i].second;
+    }
+    return dict;
+}
+
+uint64_t Position::perft_nodes(int depth) {
+    if (depth < 1) {
+        return 1;
+    }
+
+    MoveList moves;
+    int count = LegalMoveGenerator::generate(*this, moves);
+
+    // Bulk counting: The leaves do not need to be visited.
+    if (depth == 1) {
+        return count;
+    }
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < count; i++) {
+        MoveInfo info = make_unvalidated_move_fast(moves[i]);
+        nodes += perft_nodes(depth - 1);
+        unmake_move(info);
+    }
+    return nodes;
 }
 
 Position& Position::operator=(const Position& rhs) {
-    for (int i = 0; i < 128; i++) {
-        m_board[i] = rhs.m_board[i];
+    for (int i = 0; i < 64; i++) {
+        m_mailbox[i] = rhs.m_mailbox[i];
+    }
+    for (int i = 0; i < 2; i++) {
+        m_occupied_co[i] = rhs.m_occupied_co[i];
+    }
+    for (int i = 0; i < 6; i++) {
+        m_pieces[i] = rhs.m_pieces[i];
     }
 
     m_turn = rhs.m_turn;
@@ -1007,6 +1437,7 @@ Position& Position::operator=(const Position& rhs) {
     m_white_castle_kingside = rhs.m_white_castle_kingside;
     m_black_castle_queenside = rhs.m_black_castle_queenside;
     m_black_castle_kingside = rhs.m_black_castle_kingside;
+    m_hash = rhs.m_hash;
 
     return *this;
 }
@@ -1024,8 +1455,14 @@ bool Position::operator==(const Position& rhs) const {
         return false;
     }
 
-    for (int i = 0; i < 128; i++) {
-        if (m_board[i] != rhs.m_board[i]) {
+    if (m_occupied_co[0] != rhs.m_occupied_co[0] ||
+        m_occupied_co[1] != rhs.m_occupied_co[1])
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 6; i++) {
+        if (m_pieces[i] != rhs.m_pieces[i]) {
             return false;
         }
     }
@@ -1037,16 +1474,27 @@ bool Position::operator!=(const Position& rhs) const {
     return !(*this == rhs);
 }
 
-int Position::x88_index_from_square_key(const boost::python::object& square_key) const {
+unsigned char Position::castling_rights() const {
+    return (m_white_castle_kingside ? 1 : 0) |
+           (m_white_castle_queenside ? 2 : 0) |
+           (m_black_castle_kingside ? 4 : 0) |
+           (m_black_castle_queenside ? 8 : 0);
+}
+
+uint64_t Position::piece_hash(const Piece& piece, int index) {
+    // Polyglot orders the pieces as pPnNbBrRqQkK.
+    int piece_index = 2 * piece.type_index() + (piece.color() == 'w' ? 1 : 0);
+    return POLYGLOT_RANDOM_ARRAY[64 * piece_index + index];
+}
+
+Square Position::square_from_square_key(const boost::python::object& square_key) const {
     boost::python::extract<Square&> extract_square(square_key);
     if (extract_square.check()) {
-        Square& square = extract_square();
-        return square.x88_index();
+        return extract_square();
     }
     else {
         std::string square_name = boost::python::extract<std::string>(square_key);
-        Square square = Square(square_name);
-        return square.x88_index();
+        return Square(square_name);
     }
 }
 
@@ -18,8 +18,10 @@
 #define LIBCHESS_POSITION_H
 
 #include <boost/python.hpp>
+#include <vector>
 
 #include "uint.h"
+#include "bitboard.h"
 #include "piece.h"
 #include "square.h"
 #include "attacker_generator.h"
@@ -31,6 +33,11 @@ namespace chess {
 class AttackerGenerator;
 class LegalMoveGenerator;
 class PseudoLegalMoveGenerator;
+class ParallelPerft;
+class GameDatabaseReader;
+class GameDatabaseWriter;
+class PolyglotBookBuilder;
+class ParallelPgnParser;
 
 /**
  * \brief A chess position.
@@ -51,6 +58,13 @@ public:
     void __setitem__(const boost::python::object& square_key, const boost::python::object& piece);
     void __delitem__(const boost::python::object& square_key);
 
+    Bitboard occupied() const;
+    Bitboard occupied_co(char color) const;
+    Bitboard pieces(char type, char color) const;
+    Bitboard attackers_to(char color, int square, Bitboard occupied) const;
+    Bitboard attackers_to(char color, const Square& square) const;
+    bool is_attacked(char color, int square, Bitboard occupied) const;
+    bool is_attacked(char color, const Square& square) const;
 
     char turn() const;
     void set_turn(char turn);
@@ -72,7 +86,9 @@ public:
     void set_ply(int ply);
 
     std::string fen() const;
+    int write_fen(char *buffer, int size) const;
     void set_fen(const std::string& fen);
+    void set_fen(const char *fen, int length);
 
     PseudoLegalMoveGenerator *get_pseudo_legal_moves() const;
     LegalMoveGenerator *get_legal_moves() const;
@@ -97,8 +113,23 @@ public:
 
     MoveInfo make_move(const Move& move);
     void make_move_fast(const Move& move);
+    void make_move_from_san_fast(const std::string& san);
+    std::string san(const Move& move) const;
     Move get_move_from_san(const std::string& san) const;
+    Move get_move_from_san(const char *san, int length) const;
     MoveInfo make_move_from_san(const std::string& san);
+    void unmake_move(const MoveInfo& move_info);
+
+    int replay_san(const std::vector<std::string>& sans, std::vector<uint64_t> *hashes = NULL);
+    int replay_uci(const std::vector<std::string>& ucis, std::vector<uint64_t> *hashes = NULL);
+    boost::python::tuple python_replay_san(const boost::python::object& sans, bool hashes) const;
+    boost::python::tuple python_replay_uci(const boost::python::object& ucis, bool hashes) const;
+
+    uint64_t perft(int depth) const;
+    uint64_t parallel_perft(int depth, int threads, int hash_megabytes) const;
+    uint64_t python_parallel_perft(int depth, int threads, int hash_megabytes) const;
+    void divide(int depth, std::vector<std::pair<Move, uint64_t> >& results) const;
+    boost::python::dict python_divide(int depth) const;
 
     std::string __repr__() const;
     uint64_t __hash__() const;
@@ -108,9 +139,18 @@ public:
     bool operator!=(const Position& rhs) const;
 
 protected:
+    friend class MoveInfo;
+    friend class ParallelPerft;
+    friend class GameDatabaseReader;
+    friend class GameDatabaseWriter;
+    friend class PolyglotBookBuilder;
+    friend class ParallelPgnParser;
+
     MoveInfo make_unvalidated_move_fast(const Move& move);
 
-    Piece m_board[128];
+    Piece m_mailbox[64];
+    Bitboard m_occupied_co[2];
+    Bitboard m_pieces[6];
     char m_turn;
     char m_ep_file;
     int m_half_moves;
@@ -119,16 +159,23 @@ protected:
     bool m_white_castle_kingside;
     bool m_black_castle_queenside;
     bool m_black_castle_kingside;
+    uint64_t m_hash;
 
 private:
-    friend class LegalMoveGenerator;
-
-    int x88_index_from_square_key(const boost::python::object& square_key) const;
+    static uint64_t piece_hash(const Piece& piece, int index);
+    std::string san(const Move& move, bool is_check, bool is_checkmate) const;
+    uint64_t perft_nodes(int depth);
+    unsigned char castling_rights() const;
+    Square square_from_square_key(const boost::python::object& square_key) const;
 
 };
 
 std::ostream& operator<<(std::ostream& out, const Position& position);
 
+// Enough space for any FEN written by Position::write_fen(), including the
+// terminating null character.
+const int FEN_BUFFER_SIZE = 128;
+
 const std::string START_FEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
 
 extern const uint64_t POLYGLOT_RANDOM_ARRAY[];
@@ -20,183 +20,152 @@
 namespace chess {
 
 PseudoLegalMoveGenerator::PseudoLegalMoveGenerator(const Position& position) {
-    m_position = new Position(position);
     m_index = 0;
+    generate(position, m_moves);
 }
 
-PseudoLegalMoveGenerator::~PseudoLegalMoveGenerator() {
-    delete m_position;
+int PseudoLegalMoveGenerator::__len__() {
+    return m_moves.size();
+}
+
+bool PseudoLegalMoveGenerator::__nonzero__() {
+    return !m_moves.empty();
 }
 
 PseudoLegalMoveGenerator& PseudoLegalMoveGenerator::__iter__() {
     // Rewind.
     m_index = 0;
-    while (!m_cache.empty()) {
-	m_cache.pop();
-    }
     return *this;
 }
 
-void PseudoLegalMoveGenerator::generate_from_square(const Square& square) {
+bool PseudoLegalMoveGenerator::__contains__(const Move& move) {
+    return m_moves.contains(move);
+}
+
+int PseudoLegalMoveGenerator::generate(const Position& position, MoveList& moves) {
+    moves.clear();
+
+    Bitboard own = position.occupied_co(position.turn());
+    while (own) {
+	generate_from_square(position, Square(bb_pop_lsb(own)), moves);
+    }
+
+    return moves.size();
+}
+
+void PseudoLegalMoveGenerator::generate_from_square(const Position& position, const Square& square, MoveList& moves) {
     // Skip empty square and opposing pieces.
-    Piece piece = m_position->get(square);
-    if (!piece.is_valid() || piece.color() != m_position->turn()) {
+    char turn = position.turn();
+    int index = square.index();
+    if (!(position.occupied_co(turn) & bb_square(index))) {
 	return;
     }
 
+    Piece piece = position.get(square);
+    Bitboard occupied = position.occupied();
+    Bitboard own = position.occupied_co(turn);
+
     if (piece.type() == 'p') {
 	// Pawn moves: Single steps forward.
-	Square target = Square::from_x88_index(
-	    square.x88_index() + ((m_position->turn() == 'b') ? 16 : -16));
-
-	if (!m_position->get(target).is_valid()) {
-	     if (target.is_backrank()) {
-		// Promotion.
-		m_cache.push(Move(square, target, 'b'));
-		m_cache.push(Move(square, target, 'n'));
-		m_cache.push(Move(square, target, 'r'));
-		m_cache.push(Move(square, target, 'q'));
-	    } else {
-		m_cache.push(Move(square, target));
-
-		// Two steps forward.
-		if ((m_position->turn() == 'w' && square.rank() == 1) ||
-		    (m_position->turn() == 'b' && square.rank() == 6))
-		{
-		    target = Square::from_x88_index(
-			square.x88_index() + ((m_position->turn() == 'b') ? 32 : -32));
-		    if (!m_position->get(target).is_valid()) {
-			m_cache.push(Move(square, target));
-		     }
-		}
+	Bitboard pawn = bb_square(index);
+	Bitboard single = ((turn == 'w') ? bb_shift_up(pawn) : bb_shift_down(pawn)) & ~occupied;
+	if (single) {
+	    push_pawn_moves(square, Square(bb_lsb(single)), moves);
+
+	    // Two steps forward.
+	    Bitboard double_step = ((turn == 'w') ?
+		bb_shift_up(single & BB_RANK_3) :
+		bb_shift_down(single & BB_RANK_6)) & ~occupied;
+	    if (double_step) {
+		moves.push(Move(square, Square(bb_lsb(double_step))));
 	    }
 	}
 
 	// Pawn captures.
-	const int offsets[] = { 17, 15 };
-	for (int i = 0; i < 2; i++) {
-	    // Ensure the target square is on the board.
-	    int offset = (m_position->turn() == 'b') ? offsets[i] : - offsets[i];
-	    int target_index = square.x88_index() + offset;
-	    if (target_index & 0x88) {
-		continue;
-	    }
-	    Square target = Square::from_x88_index(target_index);
-	    Piece target_piece = m_position->get(target);
-	    if (target_piece.is_valid() && target_piece.color() != m_position->turn()) {
-		if (target.is_backrank()) {
-		    // Promotion.
-		    m_cache.push(Move(square, target, 'b'));
-		    m_cache.push(Move(square, target, 'n'));
-		    m_cache.push(Move(square, target, 'r'));
-		    m_cache.push(Move(square, target, 'q'));
-		} else {
-		    // Normal capture.
-		    m_cache.push(Move(square, target));
-		}
-	    } else if (target == m_position->get_ep_square()) {
-		// En-passant.
-		m_cache.push(Move(square, target));
-	    }
+	Bitboard targets = BB_PAWN_ATTACKS[piece.color_index()][index] & occupied & ~own;
+	while (targets) {
+	    push_pawn_moves(square, Square(bb_pop_lsb(targets)), moves);
+	}
+
+	// En-passant.
+	Square ep_square = position.get_ep_square();
+	if (ep_square.is_valid() && (BB_PAWN_ATTACKS[piece.color_index()][index] & bb_square(ep_square.index()))) {
+	    moves.push(Move(square, ep_square));
 	}
     } else {
 	// Other pieces.
-	const int offsets[5][9] = {
-	    { -18, -33, -31, -14, 18, 33, 31, 14, 0 }, // Knight
-	    { -17, -15, 17, 15, 0 }, // Bishop
-	    { -16, 1, 16, -1, 0 }, // Rook
-	    { -17, -16, -15, 1, 17, 16, 15, -1, 0 }, // Queen
-	    { -17, -16, -15, 1, 17, 16, 15, -1, 0 } }; // King
-
-	// Get the index of the piece in the offset table.
-	int piece_index = 0;
+	Bitboard targets = BB_VOID;
 	switch (piece.type()) {
 	    case 'n':
-		piece_index = 0;
+		targets = BB_KNIGHT_ATTACKS[index];
 		break;
 	    case 'b':
-		piece_index = 1;
+		targets = bb_bishop_attacks(index, occupied);
 		break;
 	    case 'r':
-		piece_index = 2;
+		targets = bb_rook_attacks(index, occupied);
 		break;
 	    case 'q':
-		piece_index = 3;
+		targets = bb_queen_attacks(index, occupied);
 		break;
 	    case 'k':
-		piece_index = 4;
+		targets = BB_KING_ATTACKS[index];
 		break;
 	}
 
-	// Generate the moves.
-	for (int i = 0; offsets[piece_index][i] != 0; i++) {
-	    int target_index = square.x88_index();
-	    while (true) {
-		target_index += offsets[piece_index][i];
-		if (target_index & 0x88) {
-		    break;
-		}
-
-		Square target = Square::from_x88_index(target_index);
-		Piece target_piece = m_position->get(target);
-		if (target_piece.is_valid()) {
-		    // Captures.
-		    if (target_piece.color() != m_position->turn()) {
-			m_cache.push(Move(square, target));
-		    }
-		    break;
-		} else {
-		    m_cache.push(Move(square, target));
-		}
-
-		// Knight and king do not go multiple times in their
-		// direction.
-		if (piece.type() == 'k' || piece.type() == 'n') {
-		    break;
-		}
-	    }
+	// Generate the moves and captures.
+	targets &= ~own;
+	while (targets) {
+	    moves.push(Move(square, Square(bb_pop_lsb(targets))));
 	}
-
     }
 
     if (piece.type() == 'k') {
-	int backrank = m_position->turn() == 'b' ? 7 : 0;
+	int backrank = position.turn() == 'b' ? 7 : 0;
 
 	// King-side castling.
-	if (m_position->has_kingside_castling_right(m_position->turn())) {
+	if (position.has_kingside_castling_right(position.turn())) {
 	    Square bishop_square(backrank, 5);
 	    Square knight_square(backrank, 6);
-	    if (!m_position->get(bishop_square).is_valid() && !m_position->get(knight_square).is_valid()) {
-		AttackerGenerator attacks(*m_position, opposite_color(m_position->turn()), bishop_square);
-		if (!attacks.__nonzero__()) {
-		    m_cache.push(Move(Square(backrank, 4), knight_square));
+	    if (!position.get(bishop_square).is_valid() && !position.get(knight_square).is_valid()) {
+		if (!position.is_attacked(opposite_color(position.turn()), bishop_square)) {
+		    moves.push(Move(Square(backrank, 4), knight_square));
 		}
 	    }
 	}
 
 	// Queen-side castling.
-	if (m_position->has_queenside_castling_right(m_position->turn())) {
+	if (position.has_queenside_castling_right(position.turn())) {
 	    Square knight_square(backrank, 1);
 	    Square bishop_square(backrank, 2);
 	    Square queen_square(backrank, 3);
-	    if (!m_position->get(knight_square).is_valid() &&
-		!m_position->get(bishop_square).is_valid() &&
-		!m_position->get(queen_square).is_valid())
+	    if (!position.get(knight_square).is_valid() &&
+		!position.get(bishop_square).is_valid() &&
+		!position.get(queen_square).is_valid())
 	    {
-		AttackerGenerator attacks(*m_position, opposite_color(m_position->turn()), queen_square);
-		if (!attacks.__nonzero__()) {
-		    m_cache.push(Move(Square(backrank, 4), bishop_square));
+		if (!position.is_attacked(opposite_color(position.turn()), queen_square)) {
+		    moves.push(Move(Square(backrank, 4), bishop_square));
 		}
 	    }
 	}
     }
 }
 
+void PseudoLegalMoveGenerator::push_pawn_moves(const Square& source, const Square& target, MoveList& moves) {
+    if (bb_square(target.index()) & BB_BACKRANKS) {
+	// Promotion.
+	moves.push(Move(source, target, 'b'));
+	moves.push(Move(source, target, 'n'));
+	moves.push(Move(source, target, 'r'));
+	moves.push(Move(source, target, 'q'));
+    } else {
+	moves.push(Move(source, target));
+    }
+}
+
 Move PseudoLegalMoveGenerator::next() {
     if (has_more()) {
-	Move move = m_cache.front();
-	m_cache.pop();
-	return move;
+	return m_moves[m_index++];
     } else {
 	throw std::logic_error("Called next() altough there are no more pseudo legal moves.");
     }
@@ -212,53 +181,7 @@ Move PseudoLegalMoveGenerator::python_next() {
 }
 
 bool PseudoLegalMoveGenerator::has_more() {
-    while(m_index < 64 && m_cache.empty()) {
-	generate_from_square(Square(m_index++));
-    }
-
-    return !m_cache.empty();
-}
-
-bool PseudoLegalMoveGenerator::__contains__(const Move& move) {
-    // Only need to generate the moves of the source square.
-    generate_from_square(move.source());
-
-    // See if the move is among the possible ones.
-    while (!m_cache.empty()) {
-	Move candidate_move = m_cache.front();
-	m_cache.pop();
-	if (candidate_move == move) {
-	    return true;
-	}
-    }
-    return false;
-}
-
-bool PseudoLegalMoveGenerator::__nonzero__() {
-    // Generate moves until on is found.
-    int index = 0;
-    while (index < 64) {
-	generate_from_square(Square(index++));
-	if (!m_cache.empty()) {
-	     return true;
-	}
-    }
-    return false;
-}
-
-int PseudoLegalMoveGenerator::__len__() {
-    // Clear the cache.
-    while (!m_cache.empty()) {
-	m_cache.pop();
-    }
-
-    // Generate all moves.
-    int index = 0;
-    while (index < 64) {
-	generate_from_square(Square(index++));
-    }
-
-    return m_cache.size();
+    return m_index < m_moves.size();
 }
 
 } // namespace chess
@@ -17,11 +17,9 @@
 #ifndef LIBCHESS_PSEUDO_LEGAL_MOVE_GENERATOR_H
 #define LIBCHESS_PSEUDO_LEGAL_MOVE_GENERATOR_H
 
-#include <boost/shared_ptr.hpp>
-#include <queue>
-
 #include "position.h"
 #include "move.h"
+#include "move_list.h"
 
 namespace chess {
 
@@ -29,11 +27,13 @@ class Position;
 
 /**
  * \brief Enumerates pseudo legal moves in a given position.
+ *
+ * The moves are generated into a fixed capacity MoveList up front. The
+ * static generate() can be used directly with a list on the stack.
  */
 class PseudoLegalMoveGenerator : boost::noncopyable {
 public:
      PseudoLegalMoveGenerator(const Position& position);
-     ~PseudoLegalMoveGenerator();
 
      int __len__();
      bool __nonzero__();
@@ -44,12 +44,14 @@ public:
      Move next();
      Move python_next();
 
+     static int generate(const Position& position, MoveList& moves);
+
 protected:
-     void generate_from_square(const Square& square);
-     std::queue<Move> m_cache;
+     static void generate_from_square(const Position& position, const Square& square, MoveList& moves);
+     static void push_pawn_moves(const Square& source, const Square& target, MoveList& moves);
 
 private:
-     Position* m_position;
+     MoveList m_moves;
      int m_index;
 };
 
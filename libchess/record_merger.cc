@@ -0,0 +1,152 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "record_merger.h"
+#include "polyglot_book.h"
+
+namespace chess {
+
+namespace {
+
+bool compare_weight(const PolyglotOpeningBookEntry& lhs, const PolyglotOpeningBookEntry& rhs) {
+    return lhs.weight() > rhs.weight();
+}
+
+} // anonymous namespace
+
+RecordReader::RecordReader(int fd, size_t record_size)
+    : m_fd(fd), m_record_size(record_size),
+      m_buffer(new char[BUFFER_SIZE / record_size * record_size]),
+      m_position(NULL), m_end(NULL) { }
+
+bool RecordReader::next() {
+    if (m_position) {
+        m_position += m_record_size;
+    }
+
+    if (m_position == m_end) {
+        // Fill the buffer with whole records, unless the file ends.
+        size_t capacity = BUFFER_SIZE / m_record_size * m_record_size;
+        size_t length = 0;
+        while (length < capacity) {
+            ssize_t count = read(m_fd, m_buffer.get() + length, capacity - length);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            } else if (count < 0) {
+                throw new std::invalid_argument("fd");
+            } else if (count == 0) {
+                break;
+            }
+            length += count;
+            if (length % m_record_size == 0) {
+                break;
+            }
+        }
+
+        m_position = m_buffer.get();
+        m_end = m_position + length / m_record_size * m_record_size;
+    }
+
+    return m_position != m_end;
+}
+
+const char *RecordReader::record() const {
+    return m_position;
+}
+
+/**
+ * \brief Orders the heap of files so that the smallest record is on top.
+ */
+class RecordMerger::HeapCompare {
+public:
+    HeapCompare(const RecordMerger& merger) : m_merger(merger) { }
+
+    bool operator()(int lhs, int rhs) const {
+        return m_merger.heap_less(rhs, lhs);
+    }
+
+private:
+    const RecordMerger& m_merger;
+};
+
+RecordMerger::RecordMerger(const std::vector<int>& fds, size_t record_size, Less less)
+    : m_less(less), m_current(-1)
+{
+    for (unsigned int i = 0; i < fds.size(); i++) {
+        m_readers.push_back(boost::shared_ptr<RecordReader>(new RecordReader(fds[i], record_size)));
+        if (m_readers.back()->next()) {
+            m_heap.push_back(i);
+            std::push_heap(m_heap.begin(), m_heap.end(), HeapCompare(*this));
+        }
+    }
+}
+
+bool RecordMerger::heap_less(int lhs, int rhs) const {
+    const char *a = m_readers[lhs]->record();
+    const char *b = m_readers[rhs]->record();
+    if (m_less(a, b)) {
+        return true;
+    } else if (m_less(b, a)) {
+        return false;
+    }
+    return lhs < rhs;
+}
+
+bool RecordMerger::next() {
+    // Put the file of the previous record back with its next record.
+    if (m_current >= 0 && m_readers[m_current]->next()) {
+        m_heap.push_back(m_current);
+        std::push_heap(m_heap.begin(), m_heap.end(), HeapCompare(*this));
+    }
+
+    if (m_heap.empty()) {
+        m_current = -1;
+        return false;
+    }
+
+    std::pop_heap(m_heap.begin(), m_heap.end(), HeapCompare(*this));
+    m_current = m_heap.back();
+    m_heap.pop_back();
+    return true;
+}
+
+const char *RecordMerger::record() const {
+    return m_readers[m_current]->record();
+}
+
+int RecordMerger::source() const {
+    return m_current;
+}
+
+void sort_by_weight(std::vector<PolyglotOpeningBookEntry>& entries) {
+    std::stable_sort(entries.begin(), entries.end(), compare_weight);
+}
+
+void append_entries(const std::vector<PolyglotOpeningBookEntry>& entries, std::vector<char>& buffer) {
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        char entry[PolyglotBook::ENTRY_SIZE];
+        PolyglotBookRange::encode(entries[i], entry);
+        buffer.insert(buffer.end(), entry, entry + sizeof(entry));
+    }
+}
+
+} // namespace chess
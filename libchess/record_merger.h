@@ -0,0 +1,89 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+#ifndef LIBCHESS_RECORD_MERGER_H
+#define LIBCHESS_RECORD_MERGER_H
+
+#include <cstddef>
+#include <vector>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+#include "polyglot_opening_book_entry.h"
+
+namespace chess {
+
+/**
+ * \brief Reads fixed size records from a file descriptor through a buffer.
+ *
+ * A trailing partial record is ignored. The file descriptor is not closed.
+ */
+class RecordReader : boost::noncopyable {
+public:
+    RecordReader(int fd, size_t record_size);
+
+    bool next();
+    const char *record() const;
+
+    static const size_t BUFFER_SIZE = 64 * 1024;
+
+private:
+    int m_fd;
+    size_t m_record_size;
+    boost::scoped_array<char> m_buffer;
+    const char *m_position;
+    const char *m_end;
+};
+
+/**
+ * \brief Merges files of sorted fixed size records in a single pass.
+ *
+ * The current record of each file is kept in a heap. Records that compare
+ * equal are returned in the order of the files, and records of the same
+ * file in the order of the file.
+ */
+class RecordMerger : boost::noncopyable {
+public:
+    typedef bool (*Less)(const char *lhs, const char *rhs);
+
+    RecordMerger(const std::vector<int>& fds, size_t record_size, Less less);
+
+    bool next();
+    const char *record() const;
+    int source() const;
+
+private:
+    bool heap_less(int lhs, int rhs) const;
+
+    class HeapCompare;
+
+    std::vector<boost::shared_ptr<RecordReader> > m_readers;
+    Less m_less;
+    std::vector<int> m_heap;
+    int m_current;
+};
+
+// Sorts the entries of a position by weight, keeping the order of entries
+// with the same weight.
+void sort_by_weight(std::vector<PolyglotOpeningBookEntry>& entries);
+
+// Appends the entries in the Polyglot format.
+void append_entries(const std::vector<PolyglotOpeningBookEntry>& entries, std::vector<char>& buffer);
+
+} // namespace chess
+
+#endif // LIBCHESS_RECORD_MERGER_H
@@ -20,20 +20,15 @@
 
 namespace chess {
 
-Square::Square() {
-    m_index = 64;
-}
-
-Square::Square(int index) {
-    if (index < 0 || index >= 64) {
-        throw std::invalid_argument("index");
-    }
-    m_index = index;
-}
-
-Square::Square(const Square& square) {
-    m_index = square.m_index;
-}
+const unsigned char SQUARE_X88_INDEXES[64] = {
+    112, 113, 114, 115, 116, 117, 118, 119,
+     96,  97,  98,  99, 100, 101, 102, 103,
+     80,  81,  82,  83,  84,  85,  86,  87,
+     64,  65,  66,  67,  68,  69,  70,  71,
+     48,  49,  50,  51,  52,  53,  54,  55,
+     32,  33,  34,  35,  36,  37,  38,  39,
+     16,  17,  18,  19,  20,  21,  22,  23,
+      0,   1,   2,   3,   4,   5,   6,   7 };
 
 Square::Square(const std::string& name) {
     if (name.length() != 2) {
@@ -49,45 +44,6 @@ Square::Square(const std::string& name) {
     m_index = rank * 8 + file;
 }
 
-Square::Square(int rank, int file) {
-    if (file < 0 || file >= 8) {
-        throw std::invalid_argument("file");
-    }
-    if (rank < 0 || rank >= 8) {
-        throw std::invalid_argument("rank");
-    }
-
-    m_index = rank * 8 + file;
-}
-
-int Square::rank() const {
-    if (m_index == 64) {
-        throw new std::logic_error("Called rank() of null square.");
-    } else {
-        return m_index / 8;
-    }
-}
-
-int Square::file() const {
-    if (m_index == 64) {
-        throw std::logic_error("Called file() of null square.");
-    } else {
-        return m_index % 8;
-    }
-}
-
-int Square::index() const {
-    if (m_index == 64) {
-        throw std::logic_error("Called index() of null square.");
-    } else {
-        return m_index;
-    }
-}
-
-int Square::x88_index() const {
-    return file() + 16 * (7 - rank());
-}
-
 std::string Square::name() const {
     std::string name;
     name += (file() + 'a');
@@ -103,52 +59,30 @@ char Square::rank_name() const {
     return rank() + '1';
 }
 
-bool Square::is_dark() const {
-    return index() % 2 == 0;
-}
-
-bool Square::is_light() const {
-    return index() % 2 == 1;
-}
-
-bool Square::is_backrank() const {
-    return rank() == 0 || rank() == 7;
-}
-
-bool Square::is_seventh() const {
-    return rank() == 1 || rank() == 6;
-}
-
 std::string Square::__repr__() const {
     return boost::str(boost::format("Square('%1%')") % name());
 }
 
-bool Square::is_valid() const {
-    return m_index != 64;
-}
-
 int Square::__hash__() const {
     return index();
 }
 
-Square& Square::operator=(const Square& rhs) {
-    m_index = rhs.m_index;
-    return *this;
-}
-
-bool Square::operator==(const Square& rhs) const {
-    return m_index == rhs.m_index;
-}
-
-bool Square::operator!=(const Square& rhs) const {
-    return m_index != rhs.m_index;
-}
-
 Square Square::from_rank_and_file(int rank, int file) {
+    if (file < 0 || file >= 8) {
+        throw std::invalid_argument("file");
+    }
+    if (rank < 0 || rank >= 8) {
+        throw std::invalid_argument("rank");
+    }
+
     return Square(rank, file);
 }
 
 Square Square::from_index(int index) {
+    if (index < 0 || index >= 64) {
+        throw std::invalid_argument("index");
+    }
+
     return Square(index);
 }
 
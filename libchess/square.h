@@ -19,17 +19,23 @@
 
 #include <iostream>
 
+#include "bitboard.h"
+
 namespace chess {
 
 /**
  * \brief The immutable coordinates of a square on the board.
+ *
+ * The constructors taking an index or a rank and a file do not validate
+ * their arguments, because they are used in the inner loops of the move
+ * generation. The static factory methods and the constructor taking a name
+ * are checked. The null square has the index 64.
  */
 class Square {
 public:
     Square();
     Square(int index);
     Square(const std::string& name);
-    Square(const Square& square);
     Square(int rank, int file);
 
     int rank() const;
@@ -50,7 +56,6 @@ public:
     std::string __repr__() const;
     int __hash__() const;
 
-    Square& operator=(const Square& rhs);
     bool operator==(const Square& rhs) const;
     bool operator!=(const Square& rhs) const;
 
@@ -59,9 +64,68 @@ public:
     static Square from_x88_index(int x88_index);
 
 private:
-    int m_index;
+    unsigned char m_index;
 };
 
+// The 0x88 index of each square.
+extern const unsigned char SQUARE_X88_INDEXES[64];
+
+inline Square::Square() {
+    m_index = 64;
+}
+
+inline Square::Square(int index) {
+    m_index = index;
+}
+
+inline Square::Square(int rank, int file) {
+    m_index = rank * 8 + file;
+}
+
+inline int Square::rank() const {
+    return m_index >> 3;
+}
+
+inline int Square::file() const {
+    return m_index & 7;
+}
+
+inline int Square::index() const {
+    return m_index;
+}
+
+inline int Square::x88_index() const {
+    return SQUARE_X88_INDEXES[m_index];
+}
+
+inline bool Square::is_dark() const {
+    return (BB_DARK_SQUARES >> m_index) & 1;
+}
+
+inline bool Square::is_light() const {
+    return (BB_LIGHT_SQUARES >> m_index) & 1;
+}
+
+inline bool Square::is_backrank() const {
+    return (BB_BACKRANKS >> m_index) & 1;
+}
+
+inline bool Square::is_seventh() const {
+    return ((BB_RANK_2 | BB_RANK_7) >> m_index) & 1;
+}
+
+inline bool Square::is_valid() const {
+    return m_index != 64;
+}
+
+inline bool Square::operator==(const Square& rhs) const {
+    return m_index == rhs.m_index;
+}
+
+inline bool Square::operator!=(const Square& rhs) const {
+    return m_index != rhs.m_index;
+}
+
 std::ostream& operator<<(std::ostream& out, const Square& square);
 
 } // namespace chess
@@ -18,6 +18,8 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 import distutils
+import distutils.ccompiler
+import distutils.sysconfig
 import os
 import setuptools
 
@@ -31,6 +33,38 @@ if opt:
     os.environ["OPT"] = " ".join(flag for flag in opt.split()
                                  if flag != "-Wstrict-prototypes")
 
+class BuildPerft(setuptools.Command):
+    """Builds the perft tool from tools/perft.cc and the library sources."""
+
+    description = "build the perft command line tool"
+    user_options = []
+
+    def initialize_options(self):
+        self.build_base = None
+
+    def finalize_options(self):
+        self.set_undefined_options("build", ("build_base", "build_base"))
+
+    def run(self):
+        extension = self.distribution.ext_modules[0]
+        compiler = distutils.ccompiler.new_compiler()
+        distutils.sysconfig.customize_compiler(compiler)
+
+        objects = compiler.compile(
+            ["tools/perft.cc"] + extension.sources,
+            output_dir=os.path.join(self.build_base, "temp.perft"),
+            include_dirs=["libchess", distutils.sysconfig.get_python_inc()])
+
+        # The library sources embed Python through Boost.Python.
+        version = (distutils.sysconfig.get_config_var("LDVERSION") or
+                   distutils.sysconfig.get_config_var("VERSION"))
+        library_dir = distutils.sysconfig.get_config_var("LIBDIR")
+        compiler.link_executable(
+            objects, "perft", output_dir=self.build_base,
+            libraries=extension.libraries + ["python" + version],
+            library_dirs=[library_dir], runtime_library_dirs=[library_dir],
+            target_lang="c++")
+
 # Module description.
 setuptools.setup(
     name="python-chess",
@@ -44,16 +78,28 @@ setuptools.setup(
     url="http://github.com/niklasf/python-chess",
     packages=["chess"],
     scripts=["scripts/ecotool.py"],
+    cmdclass={"build_perft": BuildPerft},
     ext_modules=[
         setuptools.extension.Extension(
             name="libchess",
             sources=[
                 "libchess/libchess.cc",
+                "libchess/bitboard.cc",
                 "libchess/piece.cc",
                 "libchess/square.cc",
                 "libchess/move.cc",
                 "libchess/move_info.cc",
                 "libchess/position.cc",
+                "libchess/perft.cc",
+                "libchess/pgn_parser.cc",
+                "libchess/parallel_pgn_parser.cc",
+                "libchess/pgn_index.cc",
+                "libchess/game_database.cc",
+                "libchess/file_io.cc",
+                "libchess/polyglot_book.cc",
+                "libchess/polyglot_book_builder.cc",
+                "libchess/polyglot_book_merger.cc",
+                "libchess/record_merger.cc",
                 "libchess/attacker_generator.cc",
                 "libchess/legal_move_generator.cc",
                 "libchess/pseudo_legal_move_generator.cc",
@@ -61,7 +107,8 @@ setuptools.setup(
             ],
             libraries=[
                 "boost_python",
-                "boost_regex",
+                "boost_thread",
+                "boost_system",
             ],
         ),
     ],
@@ -0,0 +1,81 @@
+# -*- coding: utf-8 -*-
+#
+# This file is part of the python-chess library.
+# Copyright (C) 2012 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+import chess
+import os
+import shutil
+import tempfile
+import unittest
+
+class GameDatabaseTestCase(unittest.TestCase):
+    """Tests the compact binary game database."""
+
+    def setUp(self):
+        self.directory = tempfile.mkdtemp()
+        self.path = os.path.join(self.directory, "games.db")
+
+    def tearDown(self):
+        shutil.rmtree(self.directory)
+
+    def test_pgn(self):
+        """Tests converting PGN games and reading them back."""
+        pgn = os.open("data/games/kasparov-deep-blue-1997.pgn", os.O_RDONLY)
+        fd = os.open(self.path, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o644)
+        writer = chess.GameDatabaseWriter(fd)
+        self.assertEqual(writer.write_pgn(chess.PgnParser(pgn)), 6)
+        writer.flush()
+        os.close(fd)
+        os.close(pgn)
+
+        fd = os.open(self.path, os.O_RDONLY)
+        reader = chess.GameDatabaseReader(fd)
+        headers, moves = reader.read_game()
+        self.assertEqual(headers["White"], "Garry Kasparov")
+        self.assertEqual(moves[0], chess.Move.from_uci("g1f3"))
+
+        games = 1
+        while reader.read_game() is not None:
+            games += 1
+        self.assertEqual(games, 6)
+        os.close(fd)
+
+    def test_write_game(self):
+        """Tests writing games from a start position."""
+        fen = "4k3/1P6/8/8/8/8/8/4K3 w - - 0 1"
+        fd = os.open(self.path, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o644)
+        writer = chess.GameDatabaseWriter(fd)
+        writer.write_game({ "FEN": fen }, [ chess.Move.from_uci("b7b8n") ])
+        self.assertRaises(ValueError, writer.write_game, {}, [ chess.Move.from_uci("e2e5") ])
+        writer.flush()
+        os.close(fd)
+
+        fd = os.open(self.path, os.O_RDONLY)
+        reader = chess.GameDatabaseReader(fd)
+        self.assertEqual(reader.read_game(), ({ "FEN": fen }, [ chess.Move.from_uci("b7b8n") ]))
+        self.assertEqual(reader.read_game(), None)
+        os.close(fd)
+
+    def test_corrupt_lengths(self):
+        """Tests that absurd lengths are rejected before allocating."""
+        for record in [b"\xff\xff\xff\xff\x0f", b"\x01\xff\xff\xff\xff\x0f", b"\x00\xff\xff\xff\xff\x0f"]:
+            with open(self.path, "wb") as f:
+                f.write(b"LCGAMES1" + record)
+
+            fd = os.open(self.path, os.O_RDONLY)
+            reader = chess.GameDatabaseReader(fd)
+            self.assertRaises(ValueError, reader.read_game)
+            os.close(fd)
@@ -40,3 +40,13 @@ class MoveTestCase(unittest.TestCase):
         """Tests the UCI move parsing."""
         self.assertEqual(chess.Move.from_uci('b5c7').uci, 'b5c7')
         self.assertEqual(chess.Move.from_uci('e7e8q').uci, 'e7e8q')
+
+    def test_raw(self):
+        """Tests the packed Polyglot move encoding."""
+        move = chess.Move.from_uci('g1f3')
+        self.assertEqual(move.raw, 6 << 6 | 21)
+        self.assertEqual(chess.Move.from_raw(move.raw), move)
+
+        promotion = chess.Move.from_uci('a7a8n')
+        self.assertEqual(promotion.raw, 1 << 12 | 48 << 6 | 56)
+        self.assertEqual(chess.Move.from_raw(promotion.raw), promotion)
@@ -17,11 +17,13 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 import chess
+import os
+import shutil
+import tempfile
 import unittest
 
 class PgnFileTestCase(unittest.TestCase):
     def test(self):
-        return
         games = chess.PgnFile.open('data/games/kasparov-deep-blue-1997.pgn')
         self.assertEqual(len(games), 6)
 
@@ -54,3 +56,40 @@ class PgnFileTestCase(unittest.TestCase):
         self.assertEqual(game[0][3].move, chess.Move.from_uci("e7e5"))
         self.assertEqual(game[0][3][0].move, chess.Move.from_uci("d1f3"))
         self.assertTrue(2 in game[0][3][0].nags)
+
+    def test_threads(self):
+        """Tests reading games in parallel."""
+        serial = chess.PgnFile.open("data/games/kasparov-deep-blue-1997.pgn")
+        parallel = chess.PgnFile.open("data/games/kasparov-deep-blue-1997.pgn", threads=2)
+        self.assertEqual(len(parallel), 6)
+        for a, b in zip(serial, parallel):
+            self.assertEqual(a.headers["Site"], b.headers["Site"])
+            while len(a):
+                a, b = a[0], b[0]
+                self.assertEqual(a.move, b.move)
+            self.assertEqual(len(b), 0)
+
+    def test_index(self):
+        """Tests reading games on demand through an index."""
+        directory = tempfile.mkdtemp()
+        try:
+            path = os.path.join(directory, "games.pgn")
+            shutil.copy("data/games/kasparov-deep-blue-1997.pgn", path)
+
+            pgn = chess.PgnFile.open(path, index=True)
+            self.assertTrue(os.path.exists(path + ".idx"))
+            self.assertEqual(len(pgn.index), 6)
+            self.assertEqual(len(pgn), 6)
+            self.assertEqual(pgn[5].headers["Site"], "06")
+            self.assertEqual(pgn[0][0].move, chess.Move.from_uci("g1f3"))
+            self.assertEqual([game.headers["Site"] for game in reversed(pgn)], ["06", "05", "04", "03", "02", "01"])
+
+            # Games are parsed once and then kept.
+            pgn[1].headers["Annotator"] = "Test"
+            self.assertEqual(pgn[1].headers["Annotator"], "Test")
+            self.assertTrue(pgn[1] is pgn[1])
+            self.assertTrue(pgn[2] in pgn)
+            self.assertEqual(pgn[1:3], [pgn[1], pgn[2]])
+        finally:
+            shutil.rmtree(directory)
+
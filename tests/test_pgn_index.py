@@ -0,0 +1,114 @@
+# -*- coding: utf-8 -*-
+#
+# This file is part of the python-chess library.
+# Copyright (C) 2012 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+import chess
+import os
+import shutil
+import tempfile
+import unittest
+
+class HeaderVisitor(chess.PgnVisitor):
+    """Collects the headers of a game."""
+
+    def __init__(self):
+        chess.PgnVisitor.__init__(self)
+        self.headers = {}
+
+    def header(self, name, value):
+        self.headers[name] = value
+
+class PgnIndexTestCase(unittest.TestCase):
+    """Tests the sidecar index of PGN files."""
+
+    def setUp(self):
+        self.directory = tempfile.mkdtemp()
+        self.path = os.path.join(self.directory, "games.pgn")
+        shutil.copy("data/games/kasparov-deep-blue-1997.pgn", self.path)
+
+    def tearDown(self):
+        shutil.rmtree(self.directory)
+
+    def test_index(self):
+        """Tests building the index and random access to games."""
+        index = chess.PgnIndex(self.path)
+        self.assertTrue(os.path.exists(self.path + ".idx"))
+        self.assertEqual(len(index), 6)
+
+        self.assertEqual(index[0].offset, 0)
+        self.assertEqual(index[3].eco, "B10")
+        self.assertEqual(index[3].date, "1997.??.??")
+        self.assertEqual(index[3].year, 1997)
+        self.assertEqual(index[3].month, 0)
+        self.assertEqual(index[5].result, "1-0")
+        self.assertRaises(IndexError, lambda: index[6])
+
+        visitor = HeaderVisitor()
+        self.assertTrue(index.parse_game(5, visitor))
+        self.assertEqual(visitor.headers["Site"], "06")
+
+    def test_append(self):
+        """Tests updating the index after games have been appended."""
+        chess.PgnIndex(self.path)
+
+        with open(self.path, "ab") as f:
+            f.write(b"\n[Event \"Appended\"]\n[Date \"2013.01.02\"]\n[WhiteElo \"2800\"]\n\n1. e4 *\n")
+
+        index = chess.PgnIndex(self.path)
+        self.assertEqual(len(index), 7)
+        self.assertEqual(index.update(), 0)
+        self.assertEqual(index[6].date, "2013.01.02")
+        self.assertEqual(index[6].white_elo, 2800)
+        self.assertEqual(index[6].result, "*")
+
+        visitor = HeaderVisitor()
+        index.parse_game(6, visitor)
+        self.assertEqual(visitor.headers["Event"], "Appended")
+
+    def test_rewritten(self):
+        """Tests that the index is rebuilt when the file is rewritten."""
+        chess.PgnIndex(self.path)
+        shutil.copy("data/games/variations-nags-and-comments.pgn", self.path)
+        self.assertEqual(len(chess.PgnIndex(self.path)), 1)
+
+    def test_rewritten_in_place(self):
+        """Tests that rewriting a later game with the same length is
+        detected."""
+        self.assertEqual(chess.PgnIndex(self.path)[5].result, "1-0")
+
+        with open(self.path, "rb") as f:
+            data = f.read()
+        offset = data.rindex(b"[Result \"1-0\"]")
+        with open(self.path, "r+b") as f:
+            f.seek(offset)
+            f.write(b"[Result \"0-1\"]")
+
+        self.assertEqual(chess.PgnIndex(self.path)[5].result, "0-1")
+
+    def test_unclosed_variation(self):
+        """Tests that an unclosed variation does not hide later games."""
+        with open(self.path, "wb") as f:
+            f.write(b"[White \"A\"]\n\n1. e4 (1. d4 e5 *\n\n"
+                    b"[White \"B\"]\n\n1. d4 *\n\n"
+                    b"[White \"C\"]\n\n1. c4 *\n")
+
+        index = chess.PgnIndex(self.path)
+        self.assertEqual(len(index), 3)
+
+        visitor = HeaderVisitor()
+        index.parse_game(2, visitor)
+        self.assertEqual(visitor.headers["White"], "C")
@@ -0,0 +1,239 @@
+# -*- coding: utf-8 -*-
+#
+# This file is part of the python-chess library.
+# Copyright (C) 2012 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+import chess
+import os
+import shutil
+import tempfile
+import unittest
+
+class RecordingVisitor(chess.PgnVisitor):
+    """Records the callbacks of the parser."""
+
+    def __init__(self):
+        chess.PgnVisitor.__init__(self)
+        self.tokens = []
+
+    def begin_game(self):
+        self.tokens.append("begin")
+
+    def header(self, name, value):
+        self.tokens.append((name, value))
+
+    def san(self, san):
+        self.tokens.append(san)
+
+    def nag(self, nag):
+        self.tokens.append(nag)
+
+    def comment(self, comment):
+        self.tokens.append("{%s}" % comment)
+
+    def begin_variation(self):
+        self.tokens.append("(")
+
+    def end_variation(self):
+        self.tokens.append(")")
+
+    def result(self, result):
+        self.tokens.append("result " + result)
+
+    def end_game(self):
+        self.tokens.append("end")
+
+    def error(self, message):
+        self.tokens.append("error " + message)
+
+class PgnParserTestCase(unittest.TestCase):
+    """Tests the native PGN parser."""
+
+    def test_tokens(self):
+        """Tests the tokens of games in a buffer."""
+        visitor = RecordingVisitor()
+        parser = chess.PgnParser(
+            "% escaped line\n"
+            "[White \"A \\\"quoted\\\" name\"]\n"
+            "[Result \"1-0\"]\n"
+            "\n"
+            "{Start} 1.e4 e5!? 2. Nf3 $13 ; rest of line\n"
+            "(2. f4 exf4) 2... Nc6?? 1-0\n"
+            "\n"
+            "1. d4 d5 *")
+        self.assertEqual(parser.parse(visitor), 2)
+        self.assertEqual(visitor.tokens, [
+            "begin", ("White", "A \"quoted\" name"), ("Result", "1-0"),
+            "{Start}", "e4", "e5", 5, "Nf3", 13, "{ rest of line}",
+            "(", "f4", "exf4", ")", "Nc6", 4, "result 1-0", "end",
+            "begin", "d4", "d5", "result *", "end"])
+
+    def test_byte_order_mark(self):
+        """Tests that only a byte order mark at the start is skipped."""
+        visitor = RecordingVisitor()
+        parser = chess.PgnParser(b"\xef\xbb\xbf[White \"\xef\xbb\xbf\"]\n\n{\xbf} *")
+        self.assertEqual(parser.parse(visitor), 1)
+        self.assertEqual(visitor.tokens, [
+            "begin", ("White", u"\xef\xbb\xbf"), u"{\xbf}", "result *", "end"])
+
+    def test_nag_before_move(self):
+        """Tests that game trees can not have NAGs in front of moves."""
+        games = []
+        builder = chess.pgn_file.GameBuilder(games.append)
+        self.assertRaises(chess.PgnError, chess.PgnParser("1. e4 ( $1 1. d4 ) *").parse, builder)
+        self.assertEqual(games, [])
+
+    def test_file(self):
+        """Tests streaming games from a file descriptor."""
+        visitor = RecordingVisitor()
+        fd = os.open("data/games/kasparov-deep-blue-1997.pgn", os.O_RDONLY)
+        try:
+            parser = chess.PgnParser(fd)
+            self.assertTrue(parser.parse_game(visitor))
+            self.assertEqual(parser.parse(visitor), 5)
+            self.assertFalse(parser.parse_game(visitor))
+        finally:
+            os.close(fd)
+
+        self.assertEqual(visitor.tokens.count("end"), 6)
+        self.assertTrue(("White", "Garry Kasparov") in visitor.tokens)
+        self.assertEqual(visitor.tokens[visitor.tokens.index("end") - 1], "result 1-0")
+
+    def test_headers(self):
+        """Tests skipping the movetext when only reading headers."""
+        visitor = RecordingVisitor()
+        parser = chess.PgnParser(
+            "[White \"A\"]\n"
+            "\n"
+            "1. e4 { [Event \"Comment\"] 1-0 } (1. d4 1-0 ; 0-1\n) e5 1/2-1/2\n"
+            "2. d4 *\n"
+            "[White \"B\"]\n"
+            "\n"
+            "1. e4\n")
+        self.assertTrue(parser.parse_headers(visitor))
+        self.assertEqual(parser.read_headers(), {})
+        self.assertEqual(parser.tell(), parser.game_offset + parser.game_length)
+        self.assertEqual(parser.read_headers(), {"White": "B"})
+        self.assertEqual(parser.read_headers(), None)
+        self.assertEqual(visitor.tokens, ["begin", ("White", "A"), "end"])
+
+        # Tag pairs end a game even in an unclosed variation.
+        pgn = ("[White \"A\"]\n\n1. e4 (1. d4 e5 *\n\n"
+               "[White \"B\"]\n\n1. d4 *\n\n"
+               "[White \"C\"]\n\n1. c4 *\n")
+        parser = chess.PgnParser(pgn)
+        self.assertEqual([parser.read_headers() for i in range(4)],
+                         [{"White": "A"}, {"White": "B"}, {"White": "C"}, None])
+        self.assertEqual(chess.PgnParser(pgn).parse(chess.PgnVisitor()), 3)
+
+        fd = os.open("data/games/kasparov-deep-blue-1997.pgn", os.O_RDONLY)
+        try:
+            parser = chess.PgnParser(fd)
+            for game in range(6):
+                self.assertEqual(parser.read_headers()["Event"], "IBM Man-Machine, New York USA")
+            self.assertEqual(parser.read_headers(), None)
+        finally:
+            os.close(fd)
+
+    def test_scan_headers(self):
+        """Tests scanning the headers of a PGN file."""
+        headers = list(chess.PgnFile.scan_headers("data/games/kasparov-deep-blue-1997.pgn"))
+        self.assertEqual(len(headers), 6)
+        self.assertEqual(headers[0]["White"], "Garry Kasparov")
+        self.assertEqual(headers[5]["Site"], "06")
+
+        directory = tempfile.mkdtemp()
+        try:
+            path = os.path.join(directory, "games.pgn")
+            with open(path, "wb") as f:
+                f.write(b"[White \"A\"]\n\n1. e4 (1. d4 e5 *\n\n"
+                        b"[White \"B\"]\n\n1. d4 *\n\n"
+                        b"[White \"C\"]\n\n1. c4 *\n")
+            self.assertEqual(list(chess.PgnFile.scan_headers(path)),
+                             [{"White": "A"}, {"White": "B"}, {"White": "C"}])
+        finally:
+            shutil.rmtree(directory)
+
+    def test_parallel(self):
+        """Tests that the parallel parser yields the same tokens in the
+        same order and reports illegal moves, also with tiny chunks."""
+        fd = os.open("data/games/immortal-games.pgn", os.O_RDONLY)
+        try:
+            serial = RecordingVisitor()
+            chess.PgnParser(fd).parse(serial)
+
+            for chunk_size in [16, 100, 4096, 1024 * 1024]:
+                os.lseek(fd, 0, os.SEEK_SET)
+                parallel = RecordingVisitor()
+                self.assertEqual(chess.ParallelPgnParser(fd, 4, chunk_size).parse(parallel), 36)
+
+                errors = [token for token in parallel.tokens if str(token).startswith("error ")]
+                self.assertTrue("error illegal san: Bh6+," in errors)
+                self.assertEqual([token for token in parallel.tokens if token not in errors], serial.tokens)
+
+            self.assertRaises(ValueError, chess.ParallelPgnParser, fd, 4, 0)
+        finally:
+            os.close(fd)
+
+    def test_parallel_without_event_tags(self):
+        """Tests splitting files whose games do not start with an Event
+        tag."""
+        with open("data/games/kasparov-deep-blue-1997.pgn", "rb") as f:
+            pgn = b"".join(line for line in f if not line.startswith(b"[Event "))
+
+        directory = tempfile.mkdtemp()
+        try:
+            path = os.path.join(directory, "games.pgn")
+            with open(path, "wb") as f:
+                f.write(pgn)
+
+            fd = os.open(path, os.O_RDONLY)
+            try:
+                serial = RecordingVisitor()
+                self.assertEqual(chess.PgnParser(fd).parse(serial), 6)
+
+                for chunk_size in [16, 100, 4096]:
+                    os.lseek(fd, 0, os.SEEK_SET)
+                    parallel = RecordingVisitor()
+                    self.assertEqual(chess.ParallelPgnParser(fd, 2, chunk_size).parse(parallel), 6)
+                    self.assertEqual(parallel.tokens, serial.tokens)
+            finally:
+                os.close(fd)
+        finally:
+            shutil.rmtree(directory)
+
+    def test_parallel_moves(self):
+        """Tests that the parallel parser passes resolved moves."""
+        class MoveVisitor(chess.PgnVisitor):
+            def __init__(self):
+                chess.PgnVisitor.__init__(self)
+                self.moves = []
+
+            def san(self, san):
+                self.moves.append(san)
+
+            def move(self, san, move):
+                self.moves.append((san, move.uci))
+
+        fd = os.open("data/games/kasparov-deep-blue-1997.pgn", os.O_RDONLY)
+        try:
+            visitor = MoveVisitor()
+            chess.ParallelPgnParser(fd, 2).parse(visitor)
+        finally:
+            os.close(fd)
+
+        self.assertEqual(visitor.moves[:2], [("Nf3", "g1f3"), ("d5", "d7d5")])
+        self.assertTrue(all(isinstance(move, tuple) for move in visitor.moves))
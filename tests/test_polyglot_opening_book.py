@@ -17,6 +17,10 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 import chess
+import os
+import shutil
+import struct
+import tempfile
 import unittest
 
 class PolyglotOpeningBookTestCase(unittest.TestCase):
@@ -43,3 +47,203 @@ class PolyglotOpeningBookTestCase(unittest.TestCase):
                 pos.make_move(entry.move)
             except StopIteration:
                 break
+
+    def test_polyglot_book(self):
+        pos = chess.Position()
+        book = chess.PolyglotBook("data/opening-books/performance.bin")
+        self.assertEqual(len(book), 92954)
+
+        entries = book.find(pos)
+        self.assertEqual([entry.move.uci for entry in entries], ["e2e4", "d2d4", "c2c4"])
+        self.assertEqual(entries[0].key, pos.__hash__())
+        self.assertRaises(IndexError, lambda: entries[3])
+
+        self.assertEqual(len(book.find_key(0)), 0)
+        self.assertEqual(book[0].key, book.find_key(book[0].key)[0].key)
+
+    def test_polyglot_book_builder(self):
+        directory = tempfile.mkdtemp()
+        try:
+            path = os.path.join(directory, "book.bin")
+            builder = chess.PolyglotBookBuilder(path, max_ply=40, threads=2, memory_megabytes=1)
+
+            fd = os.open("data/games/kasparov-deep-blue-1997.pgn", os.O_RDONLY)
+            try:
+                self.assertEqual(builder.add_pgn(fd), 6)
+            finally:
+                os.close(fd)
+            self.assertEqual(builder.finish(), 174)
+            self.assertEqual(os.listdir(directory), ["book.bin"])
+
+            book = chess.PolyglotBook(path)
+            entries = book.find(chess.Position())
+            self.assertEqual([(entry.move.uci, entry.weight) for entry in entries],
+                             [("e2e4", 5), ("g1f3", 3), ("d2d3", 1)])
+        finally:
+            shutil.rmtree(directory)
+
+    def test_polyglot_book_builder_merge_levels(self):
+        directory = tempfile.mkdtemp()
+        try:
+            # Every add_pgn() spills a run. With only two runs per level,
+            # seven runs are merged into levels while building, and the
+            # three remaining runs in finish().
+            paths = []
+            for max_runs in [2, 64]:
+                paths.append(os.path.join(directory, "book%d.bin" % max_runs))
+                builder = chess.PolyglotBookBuilder(paths[-1], threads=1, memory_megabytes=1, max_runs=max_runs)
+                for i in range(7):
+                    fd = os.open("data/games/kasparov-deep-blue-1997.pgn", os.O_RDONLY)
+                    try:
+                        self.assertEqual(builder.add_pgn(fd), 6)
+                    finally:
+                        os.close(fd)
+                self.assertEqual(builder.finish(), 174)
+
+            with open(paths[0], "rb") as a:
+                with open(paths[1], "rb") as b:
+                    self.assertEqual(a.read(), b.read())
+
+            self.assertRaises(ValueError, chess.PolyglotBookBuilder, paths[0], max_runs=1)
+        finally:
+            shutil.rmtree(directory)
+
+    def test_polyglot_book_builder_spill_failure(self):
+        directory = tempfile.mkdtemp()
+        try:
+            # Runs can not be spilled into a missing directory. The error
+            # must be reported instead of leaving add_pgn() waiting.
+            path = os.path.join(directory, "missing", "book.bin")
+            builder = chess.PolyglotBookBuilder(path, max_ply=40, threads=2, memory_megabytes=1)
+
+            fd = os.open("data/games/immortal-games.pgn", os.O_RDONLY)
+            try:
+                self.assertRaises(ValueError, builder.add_pgn, fd)
+            finally:
+                os.close(fd)
+            self.assertEqual(os.listdir(directory), [])
+        finally:
+            shutil.rmtree(directory)
+
+    def test_polyglot_book_merger(self):
+        directory = tempfile.mkdtemp()
+        try:
+            path = os.path.join(directory, "merged.bin")
+            pos = chess.Position()
+
+            merger = chess.PolyglotBookMerger("sum")
+            merger.add_book("data/opening-books/performance.bin")
+            merger.add_book("data/opening-books/performance.bin")
+            self.assertEqual(merger.merge(path), 92954)
+            entries = chess.PolyglotBook("data/opening-books/performance.bin").find(pos)
+            merged = chess.PolyglotBook(path).find(pos)
+            self.assertEqual([entry.weight for entry in merged],
+                             [min(2 * entry.weight, 65535) for entry in entries])
+
+            merger = chess.PolyglotBookMerger("first", min_weight=1, max_depth=1)
+            merger.add_book("data/opening-books/performance.bin")
+            self.assertEqual(merger.merge(path), 3)
+            self.assertEqual(chess.PolyglotBook(path)[0].key, pos.__hash__())
+
+            self.assertRaises(ValueError, chess.PolyglotBookMerger, "average")
+        finally:
+            shutil.rmtree(directory)
+
+    def test_polyglot_book_merger_first(self):
+        directory = tempfile.mkdtemp()
+        try:
+            key = chess.Position().__hash__()
+            e2e4 = 4 | 3 << 3 | 4 << 6 | 1 << 9
+
+            # The first book has the same move twice.
+            paths = [os.path.join(directory, name) for name in ("a.bin", "b.bin", "merged.bin")]
+            with open(paths[0], "wb") as f:
+                f.write(struct.pack(">QHHI", key, e2e4, 10, 0))
+                f.write(struct.pack(">QHHI", key, e2e4, 20, 0))
+            with open(paths[1], "wb") as f:
+                f.write(struct.pack(">QHHI", key, e2e4, 50, 0))
+
+            merger = chess.PolyglotBookMerger("first")
+            merger.add_book(paths[0])
+            merger.add_book(paths[1])
+            self.assertEqual(merger.merge(paths[2]), 2)
+            self.assertEqual([entry.weight for entry in chess.PolyglotBook(paths[2])], [20, 10])
+
+            merger = chess.PolyglotBookMerger("sum")
+            merger.add_book(paths[0])
+            merger.add_book(paths[1])
+            self.assertEqual(merger.merge(paths[2]), 1)
+            self.assertEqual(chess.PolyglotBook(paths[2])[0].weight, 80)
+        finally:
+            shutil.rmtree(directory)
+
+    def test_polyglot_book_merger_depth(self):
+        book = chess.PolyglotBook("data/opening-books/performance.bin")
+
+        # Walk the book breadth first, castling included.
+        keys = set()
+        level = [chess.Position()]
+        castled = False
+        for depth in range(8):
+            keys.update(pos.__hash__() for pos in level)
+            next_level = []
+            for pos in level:
+                for entry in book.find(pos):
+                    castled = castled or entry.move.uci in ("e1g1", "e1c1", "e8g8", "e8c8")
+                    child = chess.Position(pos)
+                    child.make_move(entry.move)
+                    if child.__hash__() not in keys:
+                        next_level.append(child)
+            level = next_level
+        self.assertTrue(castled)
+
+        directory = tempfile.mkdtemp()
+        try:
+            path = os.path.join(directory, "merged.bin")
+            merger = chess.PolyglotBookMerger("sum", max_depth=8)
+            merger.add_book("data/opening-books/performance.bin")
+            self.assertTrue(merger.merge(path) > 0)
+            merged = chess.PolyglotBook(path)
+            self.assertEqual(set(entry.key for entry in merged), keys & set(entry.key for entry in book))
+        finally:
+            shutil.rmtree(directory)
+
+    def test_load_into_memory(self):
+        path = "data/opening-books/performance.bin"
+        mapped = chess.PolyglotBook(path)
+        loaded = chess.PolyglotBook(path)
+        loaded.load_into_memory()
+        self.assertTrue(loaded.is_loaded_into_memory)
+
+        for i in range(0, len(mapped), 97):
+            key = mapped[i].key
+            self.assertEqual([entry.raw_move for entry in loaded.find_key(key)],
+                             [entry.raw_move for entry in mapped.find_key(key)])
+            self.assertEqual(len(loaded.find_key(key + 1)), len(mapped.find_key(key + 1)))
+
+        pos = chess.Position()
+        book = chess.PolyglotOpeningBook(path, load_into_memory=True)
+        e4 = next(book.get_entries_for_position(pos))
+        self.assertEqual(e4.move, pos.get_move_from_san("e4"))
+
+    def test_sequential_access(self):
+        book = chess.PolyglotOpeningBook("data/opening-books/performance.bin")
+        mapped = chess.PolyglotBook("data/opening-books/performance.bin")
+        self.assertEqual(len(book), len(mapped))
+        self.assertEqual(book[5].key, mapped[5].key)
+        self.assertEqual(book.next().key, mapped[6].key)
+        self.assertRaises(IndexError, lambda: book[len(book)])
+
+        keys = [entry.key for entry in book]
+        self.assertEqual(len(keys), len(mapped))
+        self.assertEqual(keys, sorted(keys))
+        self.assertEqual(next(reversed(book)).key, keys[-1])
+
+        pos = chess.Position()
+        book.seek_position(pos)
+        self.assertEqual(book.next_raw()[0], pos.__hash__())
+        self.assertEqual(book.next().move, pos.get_move_from_san("d4"))
+
+        pos.make_move_from_san("h4")
+        pos.make_move_from_san("h5")
+        self.assertRaises(KeyError, book.seek_position, pos)
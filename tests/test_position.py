@@ -17,6 +17,7 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 import chess
+import libchess
 import unittest
 
 class PositionTestCase(unittest.TestCase):
@@ -29,6 +30,25 @@ class PositionTestCase(unittest.TestCase):
         self.assertEqual(pos.fen, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")
         self.assertEqual(pos.turn, "w")
 
+    def test_fen_parsing(self):
+        """Tests parsing of FENs, EPDs and invalid FENs."""
+        pos = chess.Position("r3k2r/8/8/8/8/8/8/R3K2R b Kq - 12 40")
+        self.assertEqual(pos.fen, "r3k2r/8/8/8/8/8/8/R3K2R b Kq - 12 40")
+        self.assertEqual(pos.half_moves, 12)
+        self.assertEqual(pos.ply, 40)
+
+        # EPDs have no move counters, but may have operations.
+        pos = chess.Position("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - bm e4;")
+        self.assertEqual(pos, chess.Position())
+
+        for fen in ["rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0",
+                    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkqK - 0 1",
+                    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e4 0 1",
+                    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBN w KQkq - 0 1",
+                    "rnbqkbnr/pppppppp/17/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR - KQkq - 0 1"]:
+            self.assertRaises(ValueError, chess.Position, fen)
+
     def test_scholars_mate(self):
         """Tests the scholars mate."""
         pos = chess.Position()
@@ -90,6 +110,52 @@ class PositionTestCase(unittest.TestCase):
         self.assertFalse(e4.is_checkmate)
         self.assertFalse(e4.is_castle)
 
+    def test_lazy_move_info(self):
+        """Tests SAN and check flags computed after further moves."""
+        pos = chess.Position("r3k3/1P6/8/8/8/8/8/4K2R w Kq - 0 1")
+        castle = pos.make_move(chess.Move.from_uci("e1g1"))
+        rook_move = pos.make_move(chess.Move.from_uci("a8a1"))
+        pos.make_move_from_san_fast("b8=Q+")
+
+        self.assertEqual(castle.san, "O-O")
+        self.assertTrue(castle.is_castle)
+        self.assertEqual(rook_move.san, "Ra1")
+        self.assertFalse(rook_move.is_check)
+        self.assertEqual(pos.fen, "1Q2k3/8/8/8/8/8/8/r4RK1 b - - 0 2")
+
+        pos = chess.Position("4k3/1P6/8/8/8/8/8/4K3 w - - 0 1")
+        self.assertEqual(pos.san(chess.Move.from_uci("b7b8q")), "b8=Q+")
+        move_info = pos.make_move(chess.Move.from_uci("b7b8r"))
+        move_info.san = "b8=R"
+        self.assertEqual(move_info.san, "b8=R")
+        self.assertTrue(move_info.is_check)
+
+        # Changing the move does not change the SAN of the move made.
+        pos = chess.Position()
+        move_info = pos.make_move(chess.Move.from_uci("e2e4"))
+        move_info.move = chess.Move.from_uci("d2d4")
+        self.assertEqual(move_info.san, "e4")
+        self.assertEqual(move_info.move, chess.Move.from_uci("d2d4"))
+
+    def test_replay(self):
+        """Tests replaying lines of SANs and UCIs."""
+        pos = chess.Position()
+        final, hashes, illegal = pos.replay_san(["e4", "e5", "Qh5", "Nc6", "Bc4", "Nf6", "Qxf7#"], hashes=True)
+        self.assertEqual(pos, chess.Position())
+        self.assertTrue(final.is_checkmate())
+        self.assertEqual(len(hashes), 7)
+        self.assertEqual(hashes[-1], final.__hash__())
+        self.assertEqual(illegal, None)
+
+        final, hashes, illegal = pos.replay_uci(["e2e4", "e7e5", "e1e2", "e8e7", "e2e4"])
+        self.assertEqual(hashes, None)
+        self.assertEqual(illegal, 4)
+        self.assertEqual(final.fen, "rnbq1bnr/ppppkppp/8/4p3/4P3/8/PPPPKPPP/RNBQ1BNR w - - 2 3")
+
+        final, hashes, illegal = pos.replay_san(["d4", "d5", "Nc4", "Nf3"])
+        self.assertEqual(illegal, 2)
+        self.assertEqual(final.fen, "rnbqkbnr/ppp1pppp/8/3p4/3P4/8/PPP1PPPP/RNBQKBNR w KQkq d6 0 2")
+
     def test_pawn_captures(self):
         """Tests pawn captures in the kings gambit."""
         pos = chess.Position()
@@ -167,6 +233,25 @@ class PositionTestCase(unittest.TestCase):
         fifth_rank_move = pos.get_move_from_san("N5f3")
         self.assertEqual(fifth_rank_move, chess.Move.from_uci("g5f3"))
 
+        self.assertRaises(Exception, pos.get_move_from_san, "Nf3")
+
+    def test_san_variants(self):
+        """Tests castling with zeros, promotions and annotations in SANs."""
+        pos = chess.Position("r3k2r/1P6/8/8/8/8/8/R3K2R w KQkq - 0 1")
+        self.assertEqual(pos.get_move_from_san("O-O"), chess.Move.from_uci("e1g1"))
+        self.assertEqual(pos.get_move_from_san("0-0-0"), chess.Move.from_uci("e1c1"))
+        self.assertEqual(pos.get_move_from_san("O-O-O+"), chess.Move.from_uci("e1c1"))
+        self.assertEqual(pos.get_move_from_san("b8=Q"), chess.Move.from_uci("b7b8q"))
+        self.assertEqual(pos.get_move_from_san("b8N"), chess.Move.from_uci("b7b8n"))
+        self.assertEqual(pos.get_move_from_san("bxa8=q+!"), chess.Move.from_uci("b7a8q"))
+        self.assertEqual(pos.get_move_from_san("Rxa8?!"), chess.Move.from_uci("a1a8"))
+        self.assertEqual(pos.get_move_from_san("Rh1h7"), chess.Move.from_uci("h1h7"))
+
+        self.assertRaises(Exception, pos.get_move_from_san, "b8")
+        self.assertRaises(Exception, pos.get_move_from_san, "Kd3")
+        self.assertRaises(Exception, pos.get_move_from_san, "Ke1e2x")
+        self.assertRaises(Exception, pos.get_move_from_san, "")
+
     def test_insufficient_material(self):
         """Tests material counting."""
         # Starting position.
@@ -187,3 +272,135 @@ class PositionTestCase(unittest.TestCase):
         move_info = pos.make_move_from_san("exd6")
         self.assertTrue(move_info.is_enpassant)
         self.assertEqual(pos.fen, "rnbqkbnr/pp2pppp/2pP4/8/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 3")
+
+    def test_polyglot_hash(self):
+        """Tests the Polyglot keys of some positions."""
+        pos = chess.Position()
+        self.assertEqual(pos.__hash__(), 0x463b96181691fc9c)
+
+        for uci in ["e2e4", "d7d5", "e4e5", "f7f5"]:
+            pos.make_move(chess.Move.from_uci(uci))
+        self.assertEqual(pos.__hash__(), 0x22a48b5a8e47ff78)
+
+        # The en-passant file is only hashed if a pawn can capture.
+        pos = chess.Position()
+        for uci in ["a2a4", "b7b5", "h2h4", "b5b4", "c2c4"]:
+            pos.make_move(chess.Move.from_uci(uci))
+        self.assertEqual(pos.__hash__(), 0x3c8123ea7b067637)
+        pos.make_move(chess.Move.from_uci("b4c3"))
+        pos.make_move(chess.Move.from_uci("a1a3"))
+        self.assertEqual(pos.__hash__(), 0x5c3f9b829b279560)
+
+    def test_incremental_hash(self):
+        """Tests that the hash is kept up to date when making moves."""
+        pos = chess.Position("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1")
+        pos.make_move(chess.Move.from_uci("a1a8"))
+        self.assertEqual(pos.fen, "R3k2r/8/8/8/8/8/8/4K2R b Kk - 0 1")
+        self.assertEqual(pos.__hash__(), chess.Position(pos.fen).__hash__())
+
+        pos.set_kingside_castling_right("b", False)
+        pos.turn = "w"
+        self.assertEqual(pos.__hash__(), chess.Position("R3k2r/8/8/8/8/8/8/4K2R w K - 0 1").__hash__())
+
+    def test_unmake_move(self):
+        """Tests taking back moves."""
+        fen = "r3k2r/pPp2ppp/8/3pP3/8/8/P1PP1PPP/R3K2R w KQkq d6 3 12"
+        pos = chess.Position(fen)
+        for uci in ["e1g1", "e1c1", "e5d6", "b7a8q", "a1b1"]:
+            move_info = pos.make_move(chess.Move.from_uci(uci))
+            self.assertNotEqual(pos.fen, fen)
+            pos.unmake_move(move_info)
+            self.assertEqual(pos.fen, fen)
+            self.assertEqual(pos.__hash__(), chess.Position(fen).__hash__())
+
+        # Move infos that were not returned by make_move() are rejected.
+        pos = chess.Position()
+        pos.make_move(chess.Move.from_uci("e2e4"))
+        fen = pos.fen
+        move_info = libchess.MoveInfo(chess.Move.from_uci("e2e4"), chess.Piece("P"))
+        self.assertRaises(ValueError, pos.unmake_move, move_info)
+        self.assertEqual(pos.fen, fen)
+
+    def test_legal_moves_in_check(self):
+        """Tests legal move generation with checks and pins."""
+        # Castling out of check is not allowed.
+        pos = chess.Position("r3k2r/8/8/8/4q3/8/8/R3K2R w KQkq - 0 1")
+        self.assertFalse(chess.Move.from_uci("e1g1") in pos.get_legal_moves())
+        self.assertFalse(chess.Move.from_uci("e1c1") in pos.get_legal_moves())
+
+        # Pinned pieces can only move along the pin.
+        pos = chess.Position("4k3/8/8/8/4r3/8/4R3/4K2b w - - 0 1")
+        self.assertTrue(chess.Move.from_uci("e2e4") in pos.get_legal_moves())
+        self.assertFalse(chess.Move.from_uci("e2d2") in pos.get_legal_moves())
+        self.assertEqual(len(pos.get_legal_moves()), 6)
+
+        # En-passant must not expose the king along the rank.
+        pos = chess.Position("8/8/8/K2pP2r/8/8/8/7k w - d6 0 2")
+        self.assertFalse(chess.Move.from_uci("e5d6") in pos.get_legal_moves())
+
+    def test_attackers(self):
+        """Tests attacker masks and the attacker generator."""
+        pos = chess.Position("r1bqkb1r/pppp1Qpp/2n2n2/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4")
+
+        e8 = chess.Square("e8")
+        f7 = chess.Square("f7")
+        self.assertTrue(pos.is_attacked("w", e8))
+        self.assertEqual(pos.attackers_to("w", e8), 1 << f7.index)
+        self.assertEqual(pos.attackers_to("b", f7), 1 << e8.index)
+        self.assertFalse(pos.is_attacked("w", chess.Square("h6")))
+        self.assertEqual(pos.attackers_to("w", chess.Square("h6")), 0)
+
+        attackers = pos.get_attackers("w", f7)
+        self.assertEqual(len(attackers), 1)
+        self.assertTrue(chess.Square("c4") in attackers)
+        self.assertFalse(chess.Square("f7") in attackers)
+        self.assertEqual(list(attackers), [chess.Square("c4")])
+
+        attackers = pos.get_attackers("b", chess.Square("e7"))
+        self.assertEqual(len(attackers), 4)
+        self.assertEqual(list(attackers), [chess.Square("c6"), chess.Square("d8"), chess.Square("e8"), chess.Square("f8")])
+
+    def test_mate_detection(self):
+        """Tests checkmate and stalemate detection."""
+        # The check can only be blocked with a double step.
+        pos = chess.Position("1r1b3k/8/8/8/K6q/8/2P5/2b5 w - - 0 1")
+        self.assertFalse(pos.is_checkmate())
+        self.assertEqual([move.uci for move in pos.get_legal_moves()], ["c2c4"])
+
+        pos = chess.Position("1r1b3k/8/8/8/K6q/8/8/2b5 w - - 0 1")
+        self.assertTrue(pos.is_checkmate())
+        self.assertFalse(pos.is_stalemate())
+
+        # The pinned bishop can not interpose.
+        pos = chess.Position("7k/8/2b5/8/8/8/6BP/r6K w - - 0 1")
+        self.assertTrue(pos.is_checkmate())
+
+        pos = chess.Position("k7/8/1Q6/8/8/8/8/7K b - - 0 1")
+        self.assertTrue(pos.is_stalemate())
+        self.assertTrue(pos.is_game_over())
+
+    def test_perft(self):
+        """Tests perft and divide against known node counts."""
+        pos = chess.Position()
+        self.assertEqual(pos.perft(0), 1)
+        self.assertEqual(pos.perft(1), 20)
+        self.assertEqual(pos.perft(3), 8902)
+
+        pos = chess.Position("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1")
+        self.assertEqual(pos.perft(2), 2039)
+
+        divide = pos.divide(2)
+        self.assertEqual(len(divide), 48)
+        self.assertEqual(divide[chess.Move.from_uci("e1g1")], 43)
+        self.assertEqual(sum(divide.values()), 2039)
+
+    def test_parallel_perft(self):
+        """Tests perft with multiple threads and a hash table."""
+        pos = chess.Position()
+        self.assertEqual(pos.parallel_perft(4, 3, 0), 197281)
+        self.assertEqual(pos.parallel_perft(4, 2, 1), 197281)
+
+        pos = chess.Position("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1")
+        self.assertEqual(pos.parallel_perft(4, 0, 1), 43238)
+        self.assertEqual(pos.parallel_perft(3), 2812)
+        self.assertEqual(pos.parallel_perft(3, hash_megabytes=1), 2812)
@@ -49,6 +49,14 @@ class SquareTestCase(unittest.TestCase):
         self.assertEqual(f7.rank, 6)
         self.assertFalse(f7.is_backrank())
 
+    def test_square_colors(self):
+        """Tests the colors of squares on different ranks."""
+        self.assertTrue(chess.Square("a1").is_dark())
+        self.assertTrue(chess.Square("a2").is_light())
+        self.assertTrue(chess.Square("h1").is_light())
+        self.assertTrue(chess.Square("h8").is_dark())
+        self.assertFalse(chess.Square("d1").is_dark())
+
     def test_creation(self):
         """Tests creation of Square instances."""
         self.assertEqual(chess.Square.from_rank_and_file(5, 3), chess.Square("d6"))
@@ -0,0 +1,108 @@
+// This file is part of the python-chess library.
+// Copyright (C) 2013 Niklas Fiekas <niklas.fiekas@tu-clausthal.de>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have recieved a copy of the GNU General Public License
+// along with this program. If not, see <http://gnu.org/licenses/>.
+
+// Counts the leaf nodes of the legal move tree of a position, to test the
+// move generation and to measure its speed.
+//
+// Usage: perft [--divide] [--threads N] [--hash MB] <depth> [fen]
+//
+// With --threads the tree is searched in parallel, using all cores if N is
+// 0. --hash enables a shared transposition table of the given size.
+//
+// Build it with `python setup.py build_perft`, which compiles it together
+// with the library sources into build/perft.
+
+#include <cstring>
+#include <iostream>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "libchess.h"
+
+using namespace chess;
+
+int usage() {
+    std::cerr << "Usage: perft [--divide] [--threads N] [--hash MB] <depth> [fen]" << std::endl;
+    return 2;
+}
+
+int main(int argc, char *argv[]) {
+    bool divide = false;
+    int threads = 1;
+    int hash_megabytes = 0;
+    int depth;
+    int arg = 1;
+    try {
+        for (; arg < argc && std::strncmp(argv[arg], "--", 2) == 0; arg++) {
+            if (std::strcmp(argv[arg], "--divide") == 0) {
+                divide = true;
+            } else if (std::strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+                threads = boost::lexical_cast<int>(argv[++arg]);
+            } else if (std::strcmp(argv[arg], "--hash") == 0 && arg + 1 < argc) {
+                hash_megabytes = boost::lexical_cast<int>(argv[++arg]);
+            } else {
+                return usage();
+            }
+        }
+
+        if (arg >= argc || arg + 2 < argc) {
+            return usage();
+        }
+
+        depth = boost::lexical_cast<int>(argv[arg]);
+    } catch (const boost::bad_lexical_cast&) {
+        return usage();
+    }
+
+    Position position;
+    if (arg + 1 < argc) {
+        try {
+            position.set_fen(argv[arg + 1]);
+        } catch (const std::invalid_argument *e) {
+            std::cerr << "Invalid FEN: " << argv[arg + 1] << std::endl;
+            delete e;
+            return 2;
+        }
+    }
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+
+    uint64_t nodes = 0;
+    if (divide && depth >= 1) {
+        std::vector<std::pair<Move, uint64_t> > results;
+        position.divide(depth, results);
+        for (unsigned int i = 0; i < results.size(); i++) {
+            std::cout << results[i].first << ": " << results[i].second << std::endl;
+            nodes += results[i].second;
+        }
+        std::cout << std::endl;
+    } else if (threads != 1 || hash_megabytes) {
+        nodes = position.parallel_perft(depth, threads, hash_megabytes);
+    } else {
+        nodes = position.perft(depth);
+    }
+
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start;
+    double seconds = elapsed.total_microseconds() / 1e6;
+
+    std::cout << "Nodes: " << nodes << std::endl;
+    std::cout << "Time: " << seconds << " s" << std::endl;
+    if (seconds > 0) {
+        std::cout << "Nodes per second: " << (uint64_t) (nodes / seconds) << std::endl;
+    }
+
+    return 0;
+}